@@ -0,0 +1,87 @@
+import argparse
+import glob
+import os
+import struct
+
+import numpy as np
+import pandas as pd
+
+# column types, must match ColumnType in test/row_sink.h
+TYPE_F64 = 0
+TYPE_U64 = 1
+TYPE_STR = 2
+
+MAGIC = b'XEVBIN01'
+
+
+def read_binary_output(filename):
+    with open(filename, 'rb') as f:
+        data = f.read()
+
+    if data[:8] != MAGIC:
+        raise ValueError(F"'{filename}' is not a x_evaluate binary columnar file")
+
+    offset = 8
+    num_columns, = struct.unpack_from('<I', data, offset)
+    offset += 4
+
+    names, types = [], []
+    for _ in range(num_columns):
+        col_type, name_len = struct.unpack_from('<BH', data, offset)
+        offset += 3
+        names.append(data[offset:offset + name_len].decode())
+        types.append(col_type)
+        offset += name_len
+
+    columns = [[] for _ in range(num_columns)]
+
+    while offset < len(data):
+        num_rows, = struct.unpack_from('<Q', data, offset)
+        offset += 8
+        for i in range(num_columns):
+            byte_size, = struct.unpack_from('<Q', data, offset)
+            offset += 8
+            chunk = data[offset:offset + byte_size]
+            offset += byte_size
+            if types[i] == TYPE_F64:
+                columns[i].append(np.frombuffer(chunk, dtype=np.float64))
+            elif types[i] == TYPE_U64:
+                columns[i].append(np.frombuffer(chunk, dtype=np.uint64))
+            else:
+                strings = []
+                pos = 0
+                for _ in range(num_rows):
+                    str_len, = struct.unpack_from('<I', chunk, pos)
+                    pos += 4
+                    strings.append(chunk[pos:pos + str_len].decode())
+                    pos += str_len
+                columns[i].append(strings)
+
+    frame = {}
+    for name, col_type, chunks in zip(names, types, columns):
+        if col_type == TYPE_STR:
+            frame[name] = [s for chunk in chunks for s in chunk]
+        else:
+            frame[name] = np.concatenate(chunks) if len(chunks) > 0 else np.array([])
+    return pd.DataFrame(frame)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts binary columnar outputs (--binary_outputs) back to the CSV'
+                                                 ' files expected by the python evaluation pipeline')
+
+    parser.add_argument('--input_folder', type=str, required=True)
+    parser.add_argument('--keep_bin', help="Keep the .bin files after conversion", action="store_true", default=False)
+    args = parser.parse_args()
+
+    for filename in sorted(glob.glob(os.path.join(args.input_folder, "*.bin"))):
+        csv_filename = os.path.splitext(filename)[0] + ".csv"
+        print(F"Converting '{filename}' to '{csv_filename}'")
+        df = read_binary_output(filename)
+        df.to_csv(csv_filename, sep=';', index=False)
+        if not args.keep_bin:
+            os.remove(filename)
+
+
+if __name__ == '__main__':
+    main()
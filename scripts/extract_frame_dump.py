@@ -0,0 +1,87 @@
+import argparse
+import os
+import struct
+
+import cv2
+import numpy as np
+import pandas as pd
+
+# must match test/frame_dump.h
+MAGIC = b'XEVFDUMP'
+INDEX_MAGIC = b'XEVFDIDX'
+CODEC_RAW = 0
+CODEC_ZSTD = 1
+
+
+def read_frame_dump(filename):
+    """Yields (t, type, image) tuples from a frames.xfd container written with --compressed_frame_dump."""
+    with open(filename, 'rb') as f:
+        data = f.read()
+
+    if data[:8] != MAGIC:
+        raise ValueError(F"'{filename}' is not a x_evaluate frame dump file")
+    if data[-8:] != INDEX_MAGIC:
+        raise ValueError(F"'{filename}' is truncated (index footer missing)")
+
+    version, codec = struct.unpack_from('<IB', data, 8)
+    if version != 1:
+        raise ValueError(F"unsupported frame dump version {version}")
+
+    decompress = None
+    if codec == CODEC_ZSTD:
+        import zstandard
+        decompress = zstandard.ZstdDecompressor().decompress
+
+    index_offset, = struct.unpack_from('<Q', data, len(data) - 16)
+    num_frames, = struct.unpack_from('<Q', data, index_offset)
+    offsets = np.frombuffer(data, dtype=np.uint64, count=num_frames, offset=index_offset + 8)
+
+    for offset in offsets:
+        offset = int(offset)
+        type_len, = struct.unpack_from('<I', data, offset)
+        offset += 4
+        image_type = data[offset:offset + type_len].decode()
+        offset += type_len
+        t, rows, cols, cv_type, raw_size, stored_size = struct.unpack_from('<dIIiQQ', data, offset)
+        offset += 8 + 4 + 4 + 4 + 8 + 8
+
+        raw = data[offset:offset + stored_size]
+        if decompress is not None:
+            raw = decompress(raw, max_output_size=raw_size)
+
+        channels = (cv_type >> 3) + 1
+        shape = (rows, cols) if channels == 1 else (rows, cols, channels)
+        image = np.frombuffer(raw, dtype=np.uint8).reshape(shape)
+        yield t, image_type, image
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Extracts a frames.xfd container (--compressed_frame_dump) into the"
+                                                 " frames/ + dumped_frames.csv layout read by"
+                                                 " visualize_frame_output.py")
+    parser.add_argument('--input', required=True, type=str, help="frames.xfd file or folder containing one")
+    args = parser.parse_args()
+
+    input_file = args.input
+    if os.path.isdir(input_file):
+        input_file = os.path.join(input_file, "frames.xfd")
+
+    output_folder = os.path.dirname(os.path.abspath(input_file))
+    frames_folder = os.path.join(output_folder, "frames")
+    os.makedirs(frames_folder, exist_ok=True)
+
+    rows = []
+    counters = {}
+    for t, image_type, image in read_frame_dump(input_file):
+        counters[image_type] = counters.get(image_type, 0) + 1
+        filename = F"{image_type}_{counters[image_type]:07d}.png"
+        cv2.imwrite(os.path.join(frames_folder, filename), image)
+        rows.append({'t': t, 'type': image_type, 'filename': filename})
+
+    df = pd.DataFrame(rows)
+    df.to_csv(os.path.join(output_folder, "dumped_frames.csv"), sep=";", index=False)
+    print(F"Extracted {len(rows)} frames to {frames_folder}")
+
+
+if __name__ == '__main__':
+    main()
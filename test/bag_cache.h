@@ -0,0 +1,211 @@
+//
+// Created by Florian Mahlknecht on 2022-04-19.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Flat binary cache of the already-decoded IMU / image / event / pose streams of a rosbag. Written once with
+// BagCacheWriter, then replayed via mmap without touching rosbag deserialization again --> repeat runs on the same
+// sequence (parameter sweeps) skip minutes of decode overhead on large event bags.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace x_evaluate {
+
+enum class MsgKind : uint8_t {
+  IMU = 0,
+  IMAGE = 1,
+  EVENTS = 2,
+  GT_POSE = 3,
+  IGNORE = 255,
+};
+
+#pragma pack(push, 1)
+
+struct CacheFileHeader {
+  char magic[8];  // "XEVCACHE"
+  uint32_t version;
+  uint64_t num_records;
+  double t_begin;
+  double t_end;
+};
+
+struct CacheRecordHeader {
+  uint8_t kind;      // MsgKind
+  double t_bag;      // bag (receive) time, drives the replay bookkeeping
+  uint64_t payload_size;
+};
+
+struct CachedImu {
+  double t;
+  uint32_t seq;
+  double w[3];
+  double a[3];
+};
+
+struct CachedImageHeader {
+  double t;
+  uint32_t seq;
+  uint32_t height;
+  uint32_t width;
+  uint32_t step;
+  char encoding[32];
+  uint64_t data_size;  // image bytes follow directly after this header
+};
+
+struct CachedEventsHeader {
+  double t;
+  uint32_t seq;
+  uint32_t height;
+  uint32_t width;
+  uint64_t num_events;  // CachedEvent[num_events] follow directly after this header
+};
+
+struct CachedEvent {
+  uint16_t x;
+  uint16_t y;
+  double t;
+  uint8_t polarity;
+};
+
+struct CachedPose {
+  double t;
+  double p[3];
+  double q[4];  // x, y, z, w
+};
+
+#pragma pack(pop)
+
+constexpr char kCacheMagic[8] = {'X', 'E', 'V', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t kCacheVersion = 1;
+
+/**
+ * Streams decoded messages into the cache file. The header is re-written on close() once the record count is known.
+ */
+class BagCacheWriter {
+ public:
+  explicit BagCacheWriter(const std::string &filename)
+    : out_(filename, std::ios::binary | std::ios::trunc), filename_(filename) {
+    if (!out_)
+      throw std::runtime_error("unable to open cache file '" + filename + "' for writing");
+    CacheFileHeader header {};
+    out_.write(reinterpret_cast<const char *>(&header), sizeof header);  // placeholder
+  }
+
+  void writeRecord(MsgKind kind, double t_bag, const void *payload, uint64_t payload_size,
+                   const void *extra = nullptr, uint64_t extra_size = 0) {
+    CacheRecordHeader rec {static_cast<uint8_t>(kind), t_bag, payload_size + extra_size};
+    out_.write(reinterpret_cast<const char *>(&rec), sizeof rec);
+    out_.write(reinterpret_cast<const char *>(payload), static_cast<std::streamsize>(payload_size));
+    if (extra_size > 0)
+      out_.write(reinterpret_cast<const char *>(extra), static_cast<std::streamsize>(extra_size));
+    ++num_records_;
+    if (t_bag < t_begin_) t_begin_ = t_bag;
+    if (t_bag > t_end_) t_end_ = t_bag;
+  }
+
+  void close() {
+    CacheFileHeader header {};
+    std::memcpy(header.magic, kCacheMagic, sizeof header.magic);
+    header.version = kCacheVersion;
+    header.num_records = num_records_;
+    header.t_begin = t_begin_;
+    header.t_end = t_end_;
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char *>(&header), sizeof header);
+    out_.close();
+    if (!out_)
+      throw std::runtime_error("writing cache file '" + filename_ + "' failed");
+  }
+
+ private:
+  std::ofstream out_;
+  std::string filename_;
+  uint64_t num_records_ = 0;
+  double t_begin_ = std::numeric_limits<double>::infinity();
+  double t_end_ = -std::numeric_limits<double>::infinity();
+};
+
+/**
+ * Memory-maps a cache file and iterates its records in place. Payload pointers point straight into the mapping, so
+ * the consumer reads the decoded streams without any copy or deserialization.
+ */
+class BagCacheReader {
+ public:
+  struct Record {
+    MsgKind kind;
+    double t_bag;
+    const uint8_t *payload;
+    uint64_t payload_size;
+  };
+
+  explicit BagCacheReader(const std::string &filename) {
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0)
+      throw std::runtime_error("unable to open cache file '" + filename + "'");
+    struct stat st {};
+    if (fstat(fd_, &st) != 0)
+      throw std::runtime_error("unable to stat cache file '" + filename + "'");
+    size_ = static_cast<size_t>(st.st_size);
+    data_ = static_cast<const uint8_t *>(mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0));
+    if (data_ == MAP_FAILED)
+      throw std::runtime_error("unable to mmap cache file '" + filename + "'");
+    madvise(const_cast<uint8_t *>(data_), size_, MADV_SEQUENTIAL);
+
+    if (size_ < sizeof(CacheFileHeader))
+      throw std::runtime_error("cache file '" + filename + "' is truncated");
+    std::memcpy(&header_, data_, sizeof header_);
+    if (std::memcmp(header_.magic, kCacheMagic, sizeof kCacheMagic) != 0 || header_.version != kCacheVersion)
+      throw std::runtime_error("cache file '" + filename + "' has wrong magic/version, re-run --write_cache");
+  }
+
+  ~BagCacheReader() {
+    if (data_ != nullptr && data_ != MAP_FAILED)
+      munmap(const_cast<uint8_t *>(data_), size_);
+    if (fd_ >= 0)
+      ::close(fd_);
+  }
+
+  BagCacheReader(const BagCacheReader &) = delete;
+  BagCacheReader &operator=(const BagCacheReader &) = delete;
+
+  const CacheFileHeader &header() const { return header_; }
+
+  /// Calls handler(Record) for every record in file order, filtered to [from, to] on bag time. Iteration stops
+  /// early when the handler returns false.
+  template <typename Handler>
+  void forEach(double from, double to, Handler &&handler) const {
+    const uint8_t *p = data_ + sizeof(CacheFileHeader);
+    const uint8_t *end = data_ + size_;
+    while (p + sizeof(CacheRecordHeader) <= end) {
+      CacheRecordHeader rec {};
+      std::memcpy(&rec, p, sizeof rec);
+      p += sizeof rec;
+      if (p + rec.payload_size > end)
+        throw std::runtime_error("cache file is truncated mid-record");
+      if (rec.t_bag >= from && rec.t_bag <= to) {
+        if (!handler(Record {static_cast<MsgKind>(rec.kind), rec.t_bag, p, rec.payload_size}))
+          return;
+      }
+      p += rec.payload_size;
+    }
+  }
+
+ private:
+  int fd_ = -1;
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  CacheFileHeader header_ {};
+};
+
+}  // namespace x_evaluate
@@ -0,0 +1,159 @@
+//
+// Created by Florian Mahlknecht on 2022-07-04.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Microbenchmarks for the harness hot paths: event and image message conversion, output row sinks and the
+// prefetch hand-off. Canned synthetic fixtures instead of bag data, so a conversion-path regression shows up in
+// seconds instead of a multi-minute evaluation run. Built only when google-benchmark is available (see
+// CMakeLists.txt); run with  ./benchmark_evaluate --benchmark_min_time=0.5
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+
+#include "event_conversion.h"
+#include "latency_histogram.h"
+#include "msg_conversion.h"
+#include "prefetch.h"
+#include "row_sink.h"
+
+namespace {
+
+dvs_msgs::EventArrayPtr makeEventArrayMsg(size_t num_events) {
+  auto msg = boost::make_shared<dvs_msgs::EventArray>();
+  msg->header.seq = 42;
+  msg->height = 180;
+  msg->width = 240;
+  msg->events.resize(num_events);
+  for (size_t i = 0; i < num_events; ++i) {
+    auto &e = msg->events[i];
+    e.x = static_cast<uint16_t>(i % msg->width);
+    e.y = static_cast<uint16_t>((i / msg->width) % msg->height);
+    e.ts = ros::Time(1600000000.0 + 1e-6 * static_cast<double>(i));
+    e.polarity = (i & 1) != 0;
+  }
+  return msg;
+}
+
+sensor_msgs::ImagePtr makeImageMsg(uint32_t width, uint32_t height) {
+  auto msg = boost::make_shared<sensor_msgs::Image>();
+  msg->header.seq = 7;
+  msg->header.stamp = ros::Time(1600000000.0);
+  msg->height = height;
+  msg->width = width;
+  msg->step = width;
+  msg->encoding = sensor_msgs::image_encodings::MONO8;
+  msg->data.resize(static_cast<size_t>(width) * height);
+  for (size_t i = 0; i < msg->data.size(); ++i)
+    msg->data[i] = static_cast<uint8_t>(i);  // gradient pattern, cheap but not constant
+  return msg;
+}
+
+void BM_MsgToEvents(benchmark::State &state) {
+  auto msg = makeEventArrayMsg(static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(x_evaluate::msgToEvents(msg));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MsgToEvents)->Arg(200)->Arg(8192)->Arg(80000);
+
+void BM_MsgToEventsPooled(benchmark::State &state) {
+  auto msg = makeEventArrayMsg(static_cast<size_t>(state.range(0)));
+  x_evaluate::EventArrayPool pool;
+  for (auto _ : state)
+    benchmark::DoNotOptimize(x_evaluate::msgToEventsPooled(pool, msg));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MsgToEventsPooled)->Arg(200)->Arg(8192)->Arg(80000);
+
+void BM_ConvertEventsSoA(benchmark::State &state) {
+  auto msg = makeEventArrayMsg(static_cast<size_t>(state.range(0)));
+  x_evaluate::EventBatchSoA batch;
+  std::vector<x::Event> event_list;
+  for (auto _ : state) {
+    x_evaluate::convertEventsSoA(*msg, batch);
+    x_evaluate::soaToEventList(batch, event_list);
+    benchmark::DoNotOptimize(event_list.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertEventsSoA)->Arg(200)->Arg(8192)->Arg(80000);
+
+void BM_MsgToTiledImage(benchmark::State &state) {
+  auto msg = makeImageMsg(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1)));
+  x::Params params;
+  params.n_tiles_h = 3;
+  params.n_tiles_w = 3;
+  params.max_feat_per_tile = 40;
+  for (auto _ : state) {
+    x::TiledImage image;
+    benchmark::DoNotOptimize(x_evaluate::msgToTiledImage(params, msg, image));
+  }
+}
+BENCHMARK(BM_MsgToTiledImage)->Args({240, 180})->Args({640, 480});
+
+// same column schemas as the pose / imu_bias sinks in evaluate.cpp
+void BM_PoseCsvAddRow(benchmark::State &state) {
+  auto sink = x_evaluate::makeRowSink<std::string, double, double, double, double, double, double, double, double>(
+    state.range(0) != 0, false, "/tmp/x_evaluate_benchmark_pose.csv",
+    {"update_modality", "t",
+     "estimated_p_x", "estimated_p_y", "estimated_p_z",
+     "estimated_q_x", "estimated_q_y", "estimated_q_z", "estimated_q_w"});
+  const std::string modality = "IMU";
+  double t = 1600000000.0;
+  for (auto _ : state) {
+    sink->addRow(modality, t, 0.1, -0.2, 0.3, 0.0, 0.0, 0.0, 1.0);
+    t += 1e-3;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PoseCsvAddRow)->Arg(0)->Arg(1);  // 0 = CSV text, 1 = binary columnar
+
+void BM_ImuBiasCsvAddRow(benchmark::State &state) {
+  auto sink = x_evaluate::makeRowSink<double, double, double, double, double, double, double,
+                                      double, double, double, double, double, double>(
+    state.range(0) != 0, false, "/tmp/x_evaluate_benchmark_imu_bias.csv",
+    {"t", "b_a_x", "b_a_y", "b_a_z", "b_w_x", "b_w_y", "b_w_z",
+     "sigma_b_a_x", "sigma_b_a_y", "sigma_b_a_z", "sigma_b_w_x", "sigma_b_w_y", "sigma_b_w_z"});
+  double t = 1600000000.0;
+  for (auto _ : state) {
+    sink->addRow(t, 1e-3, -1e-3, 2e-3, 1e-5, -1e-5, 2e-5, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+    t += 1e-3;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImuBiasCsvAddRow)->Arg(0)->Arg(1);
+
+void BM_LatencyHistogramRecord(benchmark::State &state) {
+  x_evaluate::LatencyHistogram hist;
+  uint64_t value = 17;
+  for (auto _ : state) {
+    hist.record(value);
+    value = value * 2862933555777941757ull + 3037000493ull;  // cheap lcg --> spread across buckets
+    value &= (1ull << 20) - 1;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LatencyHistogramRecord);
+
+// hand-off cost of the prefetch / dispatch queue per message (producer and consumer on the same thread,
+// so this measures the lock + move, not contention)
+void BM_BoundedQueueHandoff(benchmark::State &state) {
+  x_evaluate::BoundedQueue<dvs_msgs::EventArrayConstPtr> queue(16);
+  auto msg = makeEventArrayMsg(200);
+  dvs_msgs::EventArrayConstPtr out;
+  for (auto _ : state) {
+    queue.push(dvs_msgs::EventArrayConstPtr(msg));
+    queue.pop(out);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BoundedQueueHandoff);
+
+}  // namespace
+
+BENCHMARK_MAIN();
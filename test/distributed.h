@@ -0,0 +1,295 @@
+//
+// Created by Florian Mahlknecht on 2022-07-25.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Node-level work distribution for --jobs_file manifests that outgrew one machine. One evaluate process runs as the
+// coordinator (--coordinator_port) and hands out manifest indices to worker processes (--coordinator host:port)
+// started on other nodes; every node reads the same manifest from shared storage, so a job is fully described by its
+// index and the outputs land in the existing per-job output_folder layout (scripts/compare.py works unchanged).
+//
+// Line protocol over plain TCP, one '\n'-terminated message each:
+//   worker --> coordinator:  READY          (once per local slot, requests work)
+//                            DONE <idx>     (job finished, requests the next one)
+//                            FAIL <idx>     (job returned non-zero or threw; not requeued)
+//   coordinator --> worker:  JOB <idx>
+//                            BYE            (sweep complete, worker exits)
+// A dead connection requeues that worker's in-flight indices, so a lost node costs the jobs it was running, not the
+// sweep. Workers with no work left stay connected and idle until everything (including possible requeues) is done.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace x_evaluate {
+
+/// Sends one protocol line; false when the peer is gone (handled by the caller's disconnect path).
+inline bool sendLine(int fd, const std::string &line) {
+  std::string msg = line + "\n";
+  size_t sent = 0;
+  while (sent < msg.size()) {
+    ssize_t n = ::send(fd, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0)
+      return false;
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+class DistributedCoordinator {
+ public:
+  DistributedCoordinator(uint16_t port, size_t num_jobs)
+    : port_(port), num_jobs_(num_jobs) {
+    for (size_t i = 0; i < num_jobs; ++i)
+      pending_.push_back(i);
+  }
+
+  /// Serves the whole manifest and returns the number of failed jobs. Single-threaded poll() loop -- traffic is a
+  /// handful of lines per multi-minute job, the actual work happens in the worker processes.
+  size_t run() {
+    int listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+      throw std::runtime_error("coordinator: unable to create socket");
+    int reuse = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port_);
+    if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) != 0 || ::listen(listen_fd, 64) != 0) {
+      ::close(listen_fd);
+      throw std::runtime_error("coordinator: unable to listen on port " + std::to_string(port_));
+    }
+    std::cerr << "Coordinator serving " << num_jobs_ << " jobs on port " << port_ << std::endl;
+
+    while (done_ + failed_ < num_jobs_) {
+      std::vector<pollfd> fds;
+      fds.push_back({listen_fd, POLLIN, 0});
+      for (const auto &[fd, conn] : connections_) {
+        (void)conn;
+        fds.push_back({fd, POLLIN, 0});
+      }
+      if (::poll(fds.data(), fds.size(), -1) < 0)
+        continue;
+
+      if (fds[0].revents & POLLIN)
+        acceptConnection(listen_fd);
+      for (size_t i = 1; i < fds.size(); ++i)
+        if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+          serviceConnection(fds[i].fd);
+    }
+
+    for (const auto &[fd, conn] : connections_) {
+      for (size_t i = 0; i < conn.waiting_slots; ++i)
+        sendLine(fd, "BYE");
+      sendLine(fd, "BYE");  // slots blocked in a read get at least one
+      ::close(fd);
+    }
+    ::close(listen_fd);
+    return failed_;
+  }
+
+ private:
+  struct Connection {
+    std::string peer;
+    std::string buffer;
+    std::vector<size_t> in_flight;
+    size_t waiting_slots = 0;  // READY/DONE lines not yet answered with a JOB
+  };
+
+  void acceptConnection(int listen_fd) {
+    sockaddr_in peer {};
+    socklen_t peer_len = sizeof peer;
+    int fd = ::accept(listen_fd, reinterpret_cast<sockaddr *>(&peer), &peer_len);
+    if (fd < 0)
+      return;
+    char name[INET_ADDRSTRLEN] = "?";
+    ::inet_ntop(AF_INET, &peer.sin_addr, name, sizeof name);
+    connections_[fd].peer = name;
+    std::cerr << "Worker connected from " << name << std::endl;
+  }
+
+  void serviceConnection(int fd) {
+    auto &conn = connections_[fd];
+    char chunk[4096];
+    ssize_t n = ::recv(fd, chunk, sizeof chunk, 0);
+    if (n <= 0) {
+      dropConnection(fd);
+      return;
+    }
+    conn.buffer.append(chunk, static_cast<size_t>(n));
+
+    size_t newline;
+    while ((newline = conn.buffer.find('\n')) != std::string::npos) {
+      std::string line = conn.buffer.substr(0, newline);
+      conn.buffer.erase(0, newline + 1);
+      if (!handleLine(fd, conn, line))
+        return;  // connection dropped mid-burst (e.g. READY lines from a worker that already died) --> conn dangles
+    }
+  }
+
+  /// Returns false when the connection was dropped -- the caller must not touch it (or its buffer) again.
+  bool handleLine(int fd, Connection &conn, const std::string &line) {
+    std::istringstream in(line);
+    std::string verb;
+    size_t idx = 0;
+    in >> verb >> idx;
+
+    if (verb == "DONE" || verb == "FAIL") {
+      auto it = std::find(conn.in_flight.begin(), conn.in_flight.end(), idx);
+      if (it != conn.in_flight.end())
+        conn.in_flight.erase(it);
+      (verb == "DONE" ? done_ : failed_) += 1;
+      std::cerr << "Job " << idx << (verb == "DONE" ? " done" : " FAILED") << " on " << conn.peer
+                << " (" << done_ + failed_ << "/" << num_jobs_ << ")" << std::endl;
+    } else if (verb != "READY") {
+      return true;  // unknown line, ignore
+    }
+
+    if (!pending_.empty()) {
+      size_t job = pending_.front();
+      pending_.pop_front();
+      conn.in_flight.push_back(job);
+      if (!sendLine(fd, "JOB " + std::to_string(job))) {
+        dropConnection(fd);
+        return false;
+      }
+    } else {
+      ++conn.waiting_slots;  // nothing to hand out now; a requeue from a dead node may still arrive
+    }
+    return true;
+  }
+
+  /// Requeues the in-flight jobs of a dead connection and hands them to idle slots right away.
+  void dropConnection(int fd) {
+    auto node = connections_.extract(fd);
+    ::close(fd);
+    if (node.empty())
+      return;
+    auto &conn = node.mapped();
+    if (!conn.in_flight.empty())
+      std::cerr << "WARNING: worker " << conn.peer << " disconnected, requeueing "
+                << conn.in_flight.size() << " jobs" << std::endl;
+    for (size_t job : conn.in_flight)
+      pending_.push_back(job);
+
+    for (auto &[other_fd, other] : connections_) {
+      while (other.waiting_slots > 0 && !pending_.empty()) {
+        size_t job = pending_.front();
+        pending_.pop_front();
+        other.in_flight.push_back(job);
+        --other.waiting_slots;
+        if (!sendLine(other_fd, "JOB " + std::to_string(job)))
+          break;  // handled on its next poll event
+      }
+    }
+
+    // with no connection left the requeued jobs simply wait in pending_ -- the listen socket stays open, so
+    // restarted (or late-joining) workers pick them up
+    if (connections_.empty() && !pending_.empty())
+      std::cerr << "No workers connected, " << pending_.size() << " jobs waiting" << std::endl;
+  }
+
+  uint16_t port_;
+  size_t num_jobs_;
+  std::deque<size_t> pending_;
+  std::map<int, Connection> connections_;
+  size_t done_ = 0, failed_ = 0;
+};
+
+/**
+ * Worker side: connects to the coordinator, requests one job per local slot and runs them concurrently (the jobs of
+ * a manifest are independent, exactly as in the local JobScheduler mode). run_job receives the manifest index and
+ * returns the job's exit code; exceptions are caught by the caller's wrapper, not here.
+ */
+inline int runDistributedWorker(const std::string &host, uint16_t port, size_t num_slots,
+                                const std::function<int(size_t)> &run_job) {
+  addrinfo hints {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *result = nullptr;
+  if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || result == nullptr) {
+    std::cerr << "ERROR: unable to resolve coordinator host '" << host << "'" << std::endl;
+    return 1;
+  }
+  int fd = ::socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if (fd < 0 || ::connect(fd, result->ai_addr, result->ai_addrlen) != 0) {
+    std::cerr << "ERROR: unable to connect to coordinator " << host << ":" << port << std::endl;
+    ::freeaddrinfo(result);
+    if (fd >= 0)
+      ::close(fd);
+    return 1;
+  }
+  ::freeaddrinfo(result);
+  std::cerr << "Connected to coordinator " << host << ":" << port << " with " << num_slots << " slots" << std::endl;
+
+  std::mutex send_mutex;  // job threads report DONE/FAIL concurrently
+  auto sendLocked = [&](const std::string &line) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    return sendLine(fd, line);
+  };
+
+  for (size_t i = 0; i < num_slots; ++i)
+    sendLocked("READY");
+
+  std::vector<std::thread> job_threads;
+  std::string buffer;
+  char chunk[4096];
+  bool bye = false;
+  int ret = 0;
+
+  while (!bye) {
+    ssize_t n = ::recv(fd, chunk, sizeof chunk, 0);
+    if (n <= 0) {
+      std::cerr << "ERROR: lost connection to coordinator" << std::endl;
+      ret = 1;
+      break;
+    }
+    buffer.append(chunk, static_cast<size_t>(n));
+
+    size_t newline;
+    while (!bye && (newline = buffer.find('\n')) != std::string::npos) {
+      std::string line = buffer.substr(0, newline);
+      buffer.erase(0, newline + 1);
+
+      std::istringstream in(line);
+      std::string verb;
+      size_t idx = 0;
+      in >> verb >> idx;
+      if (verb == "BYE") {
+        bye = true;  // only sent when every job is accounted for --> our threads are already done
+      } else if (verb == "JOB") {
+        job_threads.emplace_back([idx, &run_job, &sendLocked] {
+          int job_ret = run_job(idx);
+          sendLocked((job_ret == 0 ? "DONE " : "FAIL ") + std::to_string(idx));
+        });
+      }
+    }
+  }
+
+  for (auto &t : job_threads)
+    t.join();
+  ::close(fd);
+  return ret;
+}
+
+}  // namespace x_evaluate
@@ -31,6 +31,7 @@
 #include <x/common/csv_writer.h>
 
 #include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
 #include <dvs_msgs/EventArray.h>
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/Imu.h>
@@ -39,61 +40,39 @@
 #define BOOST_ALLOW_DEPRECATED_HEADERS
 #include <boost/progress.hpp>
 #undef BOOST_ALLOW_DEPRECATED_HEADERS
+#include <boost/make_shared.hpp>
 
-#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <ctime>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
 
+#include "bag_cache.h"
+#include "distributed.h"
+#include "event_conversion.h"
+#include "frame_dump.h"
+#include "job_scheduler.h"
+#include "latency_histogram.h"
+#include "msg_conversion.h"
+#include "params_cache.h"
+#include "perf_counters.h"
+#include "prefetch.h"
+#include "resource_sampler.h"
+#include "row_sink.h"
+#include "trajectory_metrics.h"
 
 
-/**********************************************************************************************************************
- *     Handy functions from ros_utils.cpp (x_vio_ros) --> (ugly duplication but avoids dependency on x_vio_ros)       *
- **********************************************************************************************************************/
-
-x::EventArray::Ptr msgToEvents(const dvs_msgs::EventArrayConstPtr &events_msg_ptr) {
-  std::vector<x::Event> event_list;
-  event_list.reserve(events_msg_ptr->events.size());
-
-  for (const auto& e : events_msg_ptr->events) {
-    event_list.emplace_back(e.x, e.y, e.ts.toSec(), e.polarity);
-  }
 
-  x::EventArray::Ptr x_events(new x::EventArray(events_msg_ptr->header.seq, events_msg_ptr->height,
-                                                events_msg_ptr->width, event_list));
-  return x_events;
-}
-
-cv_bridge::CvImageConstPtr msgToImage(const sensor_msgs::ImageConstPtr &img) {
-  cv_bridge::CvImageConstPtr cv_ptr;
-  try
-  {
-    cv_ptr = cv_bridge::toCvShare(img, sensor_msgs::image_encodings::MONO8);
-  }
-  catch (cv_bridge::Exception& e)
-  {
-    ROS_ERROR("cv_bridge exception: %s", e.what());
-  }
-  return cv_ptr;
-}
-
-bool msgToTiledImage(const x::Params& params, const sensor_msgs::ImageConstPtr &img, x::TiledImage &tiledImage) {
-
-  auto cv_ptr = msgToImage(img);
-  if (!cv_ptr)
-    return false;
-
-  const unsigned int frame_number = img->header.seq;
-  auto timestamp = img->header.stamp.toSec();
-
-  // Shallow copies
-  tiledImage = x::TiledImage(cv_ptr->image, timestamp, frame_number,
-                             params.n_tiles_h, params.n_tiles_w, params.max_feat_per_tile);
-
-  return true;
-}
-
-inline x::Vector3 msgVector3ToEigen(geometry_msgs::Vector3 vector) {
-  return { vector.x, vector.y, vector.z };
-}
+// conversion helpers live in msg_conversion.h so the benchmark target exercises the same code paths
+using x_evaluate::msgToEvents;
+using x_evaluate::msgToTiledImage;
+using x_evaluate::msgVector3ToEigen;
 
 
 
@@ -120,7 +99,10 @@ std::map<std::string, Frontend> frontends {
 DEFINE_string(input_bag, "", "filename of the bag to scan");
 DEFINE_string(events_topic, "", "topic in rosbag publishing dvs_msgs::EventArray");
 DEFINE_string(image_topic, "/cam0/image_raw", "topic in rosbag publishing sensor_msgs::Image");
-DEFINE_string(pose_topic, "", "(optional) topic publishing IMU pose ground truth as geometry_msgs::PoseStamped");
+DEFINE_string(pose_topic, "", "(optional) topic publishing IMU pose ground truth as geometry_msgs::PoseStamped, "
+                              "geometry_msgs::PoseWithCovarianceStamped or tf2_msgs::TFMessage");
+DEFINE_string(gt_child_frame, "", "(optional) with tf2_msgs ground truth, only log transforms whose child_frame_id "
+                                  "matches (mocap bags broadcast several rigid bodies on /tf), empty = log all");
 DEFINE_string(imu_topic, "/imu", "topic in rosbag publishing sensor_msgs::Imu");
 DEFINE_string(params_file, "", "filename of the params.yaml to use");
 DEFINE_string(output_folder, "", "folder where to write output files, is created if not existent");
@@ -128,10 +110,77 @@ DEFINE_double(from, std::numeric_limits<double>::min(), "skip messages with time
 DEFINE_double(to, std::numeric_limits<double>::max(), "skip messages with timestamp bigger than --to");
 DEFINE_bool(dump_input_frames, false, "Whether to log input frames to disk");
 DEFINE_bool(dump_debug_frames, false, "Whether to log debug frames to disk");
+DEFINE_string(input_cache, "", "(optional) pre-decoded cache file written with --write_cache, replayed via mmap "
+                                "instead of --input_bag");
+DEFINE_string(write_cache, "", "convert --input_bag into the given pre-decoded cache file and exit");
+DEFINE_uint64(prefetch_window, 0, "if > 0, read and instantiate bag messages this many messages ahead on a "
+                                  "background thread instead of inline in the processing loop");
+DEFINE_bool(binary_outputs, false, "write pose/imu_bias/gt/realtime/resource outputs as binary columnar .bin "
+                                   "files instead of CSV text (see scripts/convert_binary_output.py)");
+DEFINE_bool(async_logging, false, "append output rows to a ring buffer drained by a dedicated flusher thread "
+                                  "instead of writing from the processing loop");
+DEFINE_bool(pooled_events, false, "recycle x::EventArray objects through an object pool in msgToEvents "
+                                  "conversion instead of allocating per message");
+DEFINE_bool(batched_event_conversion, false, "convert event fields with the batched (SIMD where available) "
+                                             "kernel instead of the per-event loop");
+DEFINE_double(max_rt_factor, 0.0, "abort the run (writing all outputs and an abort marker) once the realtime "
+                                  "factor stays above this threshold for --min_progress_check_s, 0 = disabled");
+DEFINE_double(min_progress_check_s, 10.0, "length of the simulated-time window over which --max_rt_factor must be "
+                                          "exceeded before aborting");
+DEFINE_string(sweep_params_dir, "", "resident sweep mode: decode the input once, then run one evaluation per "
+                                    "params .yaml in this directory, writing to <output_folder>/<yaml stem>");
+DEFINE_double(checkpoint_interval_s, 0.0, "write a harness checkpoint (bag cursor, counters, output flush) every "
+                                          "this many simulated seconds, 0 = disabled");
+DEFINE_string(resume_from, "", "checkpoint.yaml written by --checkpoint_interval_s; seeks the input to the "
+                               "checkpoint time and appends to the existing outputs");
+DEFINE_double(resource_sampling_interval_s, 1.0, "wall-clock interval of the resource sampler thread feeding "
+                                                 "resource.csv and resource_threads.csv");
+DEFINE_double(profiling_segment_s, 0.0, "rotate the easy_profiler capture: dump the completed blocks to "
+                                        "profiling.NNN.prof every this many simulated seconds instead of keeping "
+                                        "the whole run in memory for one profiling.prof, 0 = single dump");
+DEFINE_uint64(pose_log_decimation, 1, "log only every Nth IMU-triggered row to pose.csv/imu_bias.csv "
+                                      "(image/event-triggered updates are always logged), 1 = log everything");
+DEFINE_bool(perf_counters, false, "attribute hardware counters (instructions, cycles, cache misses, branch "
+                                  "misses via perf_event_open) to the IMU/Image/Events processing blocks, "
+                                  "written to perf_counters.csv");
+DEFINE_bool(compressed_frame_dump, false, "write the frames selected by --dump_input_frames/--dump_debug_frames "
+                                          "into one zstd-compressed container (frames.xfd, see "
+                                          "scripts/extract_frame_dump.py) on a background thread instead of the "
+                                          "per-frame image files of XVioPerformanceLogger");
+DEFINE_uint64(event_batch_size, 0, "re-chunk the event stream to this many events per processEventsMeasurement "
+                                   "call, independent of the EventArray sizes in the recording, 0 = disabled");
+DEFINE_double(event_batch_dt, 0.0, "re-chunk the event stream to time windows of this many seconds per "
+                                   "processEventsMeasurement call, 0 = disabled");
+DEFINE_bool(metrics, false, "compute sweep-scoring metrics (ATE against the --pose_topic ground truth after rigid "
+                            "alignment, realtime factor, peak RSS) in-process and write a one-line metrics.json");
+DEFINE_bool(metrics_only, false, "implies --metrics, and suppresses the per-row outputs (pose/imu_bias/gt/realtime/"
+                                 "resource) entirely -- for large sweeps where only the scores matter");
+DEFINE_double(replay_factor, 0.0, "release messages to the VIO according to their bag timestamps scaled by this "
+                                  "factor (1 = original arrival rate, 2 = twice as fast) instead of as fast as "
+                                  "possible -- reproducible arrival pattern for the multithreaded frontends, "
+                                  "0 = disabled");
+DEFINE_string(jobs_file, "", "(optional) YAML file with a list of jobs (input_bag, params_file, frontend, "
+                             "output_folder, topics), run concurrently instead of the single job from the flags");
+DEFINE_uint64(num_workers, 0, "number of worker threads for --jobs_file runs (or local slots in --coordinator "
+                              "worker mode), 0 = hardware concurrency");
+DEFINE_uint64(coordinator_port, 0, "distributed mode: serve the --jobs_file manifest to remote workers on this TCP "
+                                   "port instead of running the jobs locally, 0 = disabled");
+DEFINE_string(coordinator, "", "distributed mode: host:port of a coordinator to pull jobs from; requires the same "
+                               "--jobs_file manifest (on shared storage) as the coordinator");
 
 
 static bool validateFrontend(const char* flagname, const std::string& value) {
-  if (frontends.find(value) != frontends.end())
+  // a single frontend, or a comma-separated list for the single-pass comparison mode
+  bool all_valid = !value.empty();
+  size_t pos = 0;
+  while (all_valid && pos <= value.size()) {
+    auto comma = value.find(',', pos);
+    if (comma == std::string::npos)
+      comma = value.size();
+    all_valid = frontends.find(value.substr(pos, comma - pos)) != frontends.end();
+    pos = comma + 1;
+  }
+  if (all_valid)
     return true;
   std::string possible_values;
   bool is_first = true;
@@ -151,27 +200,200 @@ DEFINE_string(frontend, "XVIO", "which frontend to use");
 DEFINE_validator(frontend, &validateFrontend);
 
 
-using PoseCsv = x::CsvWriter<std::string,
-                             double,
-                             double, double, double,
-                             double, double, double, double>;
-using ImuBiasCsv = x::CsvWriter<double,
-                             double, double, double,
-                             double, double, double,
-                             double, double, double,
-                             double, double, double>;
-
-using GTCsv = x::CsvWriter<double,
-                           double, double, double,
-                           double, double, double, double>;
-
-void addPose(PoseCsv& csv, const std::string& update_modality, const x::State& s) {
-  csv.addRow(update_modality, s.getTime(),
-             s.getPosition().x(), s.getPosition().y(), s.getPosition().z(),
-             s.getOrientation().x(), s.getOrientation().y(), s.getOrientation().z(), s.getOrientation().w());
+/**
+ * Everything one evaluation run needs to know. Populated either from the command line flags (single-job mode) or from
+ * one entry of the --jobs_file manifest, so that several jobs can run concurrently in one process.
+ */
+struct EvalJob {
+  std::string input_bag;
+  std::string input_cache;
+  std::string events_topic;
+  std::string image_topic;
+  std::string pose_topic;
+  std::string gt_child_frame;
+  std::string imu_topic;
+  std::string params_file;
+  std::string output_folder;
+  std::string frontend;
+  double from = std::numeric_limits<double>::min();
+  double to = std::numeric_limits<double>::max();
+  size_t prefetch_window = 0;
+  bool binary_outputs = false;
+  bool async_logging = false;
+  bool pooled_events = false;
+  bool batched_event_conversion = false;
+  double max_rt_factor = 0.0;
+  double min_progress_check_s = 10.0;
+  double checkpoint_interval_s = 0.0;
+  std::string resume_from;
+  double resource_sampling_interval_s = 1.0;
+  double profiling_segment_s = 0.0;
+  size_t event_batch_size = 0;
+  double event_batch_dt = 0.0;
+  bool dump_input_frames = false;
+  bool dump_debug_frames = false;
+  bool compressed_frame_dump = false;
+  bool perf_counters = false;
+  size_t pose_log_decimation = 1;
+  double replay_factor = 0.0;
+  bool metrics = false;
+  bool metrics_only = false;
+  bool enable_profiling = true;  // easy_profiler state is process-global --> only meaningful for one job at a time
+  bool show_progress = true;   // suppressed when several runs share one terminal
+  bool deep_copy_images = false;  // detach image pixel buffers when decoded messages are shared across runs
+};
+
+EvalJob jobFromFlags() {
+  EvalJob job;
+  job.input_bag = FLAGS_input_bag;
+  job.input_cache = FLAGS_input_cache;
+  job.events_topic = FLAGS_events_topic;
+  job.image_topic = FLAGS_image_topic;
+  job.pose_topic = FLAGS_pose_topic;
+  job.gt_child_frame = FLAGS_gt_child_frame;
+  job.imu_topic = FLAGS_imu_topic;
+  job.params_file = FLAGS_params_file;
+  job.output_folder = FLAGS_output_folder;
+  job.frontend = FLAGS_frontend;
+  job.from = FLAGS_from;
+  job.to = FLAGS_to;
+  job.prefetch_window = FLAGS_prefetch_window;
+  job.binary_outputs = FLAGS_binary_outputs;
+  job.async_logging = FLAGS_async_logging;
+  job.pooled_events = FLAGS_pooled_events;
+  job.batched_event_conversion = FLAGS_batched_event_conversion;
+  job.max_rt_factor = FLAGS_max_rt_factor;
+  job.min_progress_check_s = FLAGS_min_progress_check_s;
+  job.checkpoint_interval_s = FLAGS_checkpoint_interval_s;
+  job.resume_from = FLAGS_resume_from;
+  job.resource_sampling_interval_s = FLAGS_resource_sampling_interval_s;
+  job.profiling_segment_s = FLAGS_profiling_segment_s;
+  job.event_batch_size = FLAGS_event_batch_size;
+  job.event_batch_dt = FLAGS_event_batch_dt;
+  job.dump_input_frames = FLAGS_dump_input_frames;
+  job.dump_debug_frames = FLAGS_dump_debug_frames;
+  job.compressed_frame_dump = FLAGS_compressed_frame_dump;
+  job.perf_counters = FLAGS_perf_counters;
+  job.pose_log_decimation = FLAGS_pose_log_decimation;
+  job.replay_factor = FLAGS_replay_factor;
+  job.metrics = FLAGS_metrics;
+  job.metrics_only = FLAGS_metrics_only;
+  return job;
+}
+
+std::vector<EvalJob> jobsFromManifest(const std::string &manifest_file) {
+  YAML::Node manifest = YAML::LoadFile(manifest_file);
+  std::vector<EvalJob> jobs;
+  for (const auto &entry : manifest) {
+    EvalJob job = jobFromFlags();  // flags act as defaults, e.g. for shared topic names
+    job.input_bag = entry["input_bag"].IsDefined() ? entry["input_bag"].as<std::string>() : "";
+    if (entry["input_cache"].IsDefined())
+      job.input_cache = entry["input_cache"].as<std::string>();
+    job.params_file = entry["params_file"].as<std::string>();
+    job.output_folder = entry["output_folder"].as<std::string>();
+    if (entry["frontend"].IsDefined())
+      job.frontend = entry["frontend"].as<std::string>();
+    if (entry["events_topic"].IsDefined())
+      job.events_topic = entry["events_topic"].as<std::string>();
+    if (entry["image_topic"].IsDefined())
+      job.image_topic = entry["image_topic"].as<std::string>();
+    if (entry["pose_topic"].IsDefined())
+      job.pose_topic = entry["pose_topic"].as<std::string>();
+    if (entry["gt_child_frame"].IsDefined())
+      job.gt_child_frame = entry["gt_child_frame"].as<std::string>();
+    if (entry["imu_topic"].IsDefined())
+      job.imu_topic = entry["imu_topic"].as<std::string>();
+    if (entry["from"].IsDefined())
+      job.from = entry["from"].as<double>();
+    if (entry["to"].IsDefined())
+      job.to = entry["to"].as<double>();
+    if (entry["prefetch_window"].IsDefined())
+      job.prefetch_window = entry["prefetch_window"].as<size_t>();
+    if (entry["binary_outputs"].IsDefined())
+      job.binary_outputs = entry["binary_outputs"].as<bool>();
+    if (entry["async_logging"].IsDefined())
+      job.async_logging = entry["async_logging"].as<bool>();
+    if (entry["pooled_events"].IsDefined())
+      job.pooled_events = entry["pooled_events"].as<bool>();
+    if (entry["batched_event_conversion"].IsDefined())
+      job.batched_event_conversion = entry["batched_event_conversion"].as<bool>();
+    if (entry["max_rt_factor"].IsDefined())
+      job.max_rt_factor = entry["max_rt_factor"].as<double>();
+    if (entry["min_progress_check_s"].IsDefined())
+      job.min_progress_check_s = entry["min_progress_check_s"].as<double>();
+    if (entry["resource_sampling_interval_s"].IsDefined())
+      job.resource_sampling_interval_s = entry["resource_sampling_interval_s"].as<double>();
+    if (entry["event_batch_size"].IsDefined())
+      job.event_batch_size = entry["event_batch_size"].as<size_t>();
+    if (entry["event_batch_dt"].IsDefined())
+      job.event_batch_dt = entry["event_batch_dt"].as<double>();
+    if (entry["pose_log_decimation"].IsDefined())
+      job.pose_log_decimation = entry["pose_log_decimation"].as<size_t>();
+    if (entry["replay_factor"].IsDefined())
+      job.replay_factor = entry["replay_factor"].as<double>();
+    if (entry["metrics"].IsDefined())
+      job.metrics = entry["metrics"].as<bool>();
+    if (entry["metrics_only"].IsDefined())
+      job.metrics_only = entry["metrics_only"].as<bool>();
+    if (!frontends.count(job.frontend))
+      throw std::runtime_error("invalid frontend '" + job.frontend + "' in " + manifest_file);
+    job.enable_profiling = false;
+    jobs.push_back(job);
+  }
+  return jobs;
+}
+
+
+using PoseSink = x_evaluate::RowSink<std::string,
+                                     double,
+                                     double, double, double,
+                                     double, double, double, double>;
+using ImuBiasSink = x_evaluate::RowSink<double,
+                                        double, double, double,
+                                        double, double, double,
+                                        double, double, double,
+                                        double, double, double>;
+
+using GTSink = x_evaluate::RowSink<double,
+                                   double, double, double,
+                                   double, double, double, double>;
+
+using RtSink = x_evaluate::RowSink<double, double, profiler::timestamp_t, std::string, profiler::timestamp_t>;
+using ResourceSink = x_evaluate::RowSink<profiler::timestamp_t, double, double, double, size_t, size_t>;
+using ThreadResourceSink = x_evaluate::RowSink<profiler::timestamp_t, uint64_t, std::string, double, double>;
+
+/**
+ * The handful of scalars the logging actually reads, captured right after each VIO call. Keeping the full x::State
+ * (with its dynamic-size covariance members) as a member and assigning it per message copied the whole state
+ * thousands of times per second at kHz IMU rates just to log these values. capture() binds directly to the returned
+ * temporary, so only these scalars are stored. Removing the by-value return itself needs a const-reference logging
+ * accessor on x::AbstractVio, which lives in the x library.
+ */
+struct StateSnapshot {
+  double t = -1.0;
+  double p_x = 0, p_y = 0, p_z = 0;
+  double q_x = 0, q_y = 0, q_z = 0, q_w = 1;
+  double b_a_x = 0, b_a_y = 0, b_a_z = 0;
+  double b_w_x = 0, b_w_y = 0, b_w_z = 0;
+
+  void capture(const x::State& s) {
+    t = s.getTime();
+    const auto& p = s.getPosition();
+    p_x = p.x(); p_y = p.y(); p_z = p.z();
+    const auto& q = s.getOrientation();
+    q_x = q.x(); q_y = q.y(); q_z = q.z(); q_w = q.w();
+    const auto& b_a = s.getAccelerometerBias();
+    b_a_x = b_a.x(); b_a_y = b_a.y(); b_a_z = b_a.z();
+    const auto& b_w = s.getGyroscopeBias();
+    b_w_x = b_w.x(); b_w_y = b_w.y(); b_w_z = b_w.z();
+  }
+};
+
+void addPose(PoseSink& csv, const std::string& update_modality, const StateSnapshot& s) {
+  csv.addRow(update_modality, s.t, s.p_x, s.p_y, s.p_z, s.q_x, s.q_y, s.q_z, s.q_w);
 }
 
-void addImuBias(ImuBiasCsv& csv, const std::string& update_modality, const x::State& s) {
+void addImuBias(ImuBiasSink& csv, const std::string& update_modality, const StateSnapshot& s) {
   // THIS CURRENTLY LEADS TO A SEGMENTATION FAULT ON poster_translation after 50% for some mysterious reason
 //  const x::Matrix& imu_bias_cov = s.getDynamicCovariance().bottomRightCorner<6, 6>();
 //  const double& sigma_w_x = imu_bias_cov(0, 0);
@@ -186,9 +408,9 @@ void addImuBias(ImuBiasCsv& csv, const std::string& update_modality, const x::St
   const double sigma_a_x = 0.0;
   const double sigma_a_y = 0.0;
   const double sigma_a_z = 0.0;
-  csv.addRow(s.getTime(),
-             s.getAccelerometerBias().x(), s.getAccelerometerBias().y(), s.getAccelerometerBias().z(),
-             s.getGyroscopeBias().x(), s.getGyroscopeBias().y(), s.getGyroscopeBias().z(),
+  csv.addRow(s.t,
+             s.b_a_x, s.b_a_y, s.b_a_z,
+             s.b_w_x, s.b_w_y, s.b_w_z,
              sigma_w_x, sigma_w_y, sigma_w_z, sigma_a_x, sigma_a_y, sigma_a_z);
 }
 
@@ -200,298 +422,1528 @@ char* get_time_string_in_utc() {
 }
 
 
-int evaluate(x::AbstractVio &vio, const fs::path &output_path, const x::Params& params) {
-  PoseCsv pose_csv(output_path / "pose.csv", {"update_modality", "t",
-                                              "estimated_p_x", "estimated_p_y", "estimated_p_z",
-                                              "estimated_q_x", "estimated_q_y", "estimated_q_z", "estimated_q_w"});
-  ImuBiasCsv imu_bias_csv(output_path / "imu_bias.csv", {"t", "b_a_x", "b_a_y", "b_a_z", "b_w_x", "b_w_y", "b_w_z",
-                                                         "sigma_b_a_x", "sigma_b_a_y", "sigma_b_a_z", "sigma_b_w_x", "sigma_b_w_y", "sigma_b_w_z"});
-
+/**********************************************************************************************************************
+ *                                              Core evaluation run                                                   *
+ **********************************************************************************************************************/
 
-  std::unique_ptr<GTCsv> gt_csv(nullptr);
+using x_evaluate::MsgKind;
 
-  if (!FLAGS_pose_topic.empty())
-    gt_csv.reset(new GTCsv(output_path / "gt.csv", {"t", "p_x", "p_y", "p_z", "q_x", "q_y", "q_z", "q_w"}));
+// returns static instances: the row sinks take const std::string& --> no per-message string allocation
+const std::string& msgKindName(MsgKind kind) {
+  static const std::string kImu = "IMU", kImage = "Image", kEvents = "Events", kNone;
+  switch (kind) {
+    case MsgKind::IMU: return kImu;
+    case MsgKind::IMAGE: return kImage;
+    case MsgKind::EVENTS: return kEvents;
+    default: return kNone;
+  }
+}
 
-  x::CsvWriter<double, double, profiler::timestamp_t, std::string, profiler::timestamp_t> rt_csv(
-    output_path / "realtime.csv", {"t_sim", "t_real", "ts_real", "processing_type", "process_time_in_us"});
+/**
+ * A bag message instantiated and type-tagged away from the processing thread. Decode (rosbag deserialization) happens
+ * either inline (prefetch_window == 0) or on the reader thread of the prefetch pipeline; all VIO processing and
+ * bookkeeping happens on the consumer side in dispatchMessage().
+ */
+struct PrefetchedMessage {
+  MsgKind kind = MsgKind::IGNORE;
+  double t_bag = 0.0;
+  sensor_msgs::ImuConstPtr imu;
+  sensor_msgs::ImageConstPtr image;
+  std::shared_ptr<x::TiledImage> tiled_image;  // set when the decoder stage already ran cv_bridge (see below)
+  dvs_msgs::EventArrayConstPtr events;
+  geometry_msgs::PoseStampedConstPtr gt_pose;
+  geometry_msgs::PoseWithCovarianceStampedConstPtr gt_pose_cov;
+  tf2_msgs::TFMessageConstPtr gt_tf;
+};
 
-  x::CsvWriter<profiler::timestamp_t, double, double, double, size_t, size_t> resource_csv(
-    output_path / "resource.csv",
-    {"ts", "cpu_usage", "cpu_user_mode_usage", "cpu_kernel_mode_usage", "memory_usage_in_bytes", "debug_memory_in_bytes"});
+/**
+ * Wall-clock-throttled progress reporter. boost::progress_display wrote to stderr on every message, which is
+ * measurable terminal/log-collector I/O on multi-million-message bags. This prints one line at most every
+ * interval_s seconds -- percent, message counts, the realtime factor of the run so far and an ETA extrapolated
+ * from current throughput -- and only consults the clock every 1024 messages.
+ */
+class ProgressReporter {
+ public:
+  explicit ProgressReporter(size_t total_messages, double interval_s = 5.0)
+    : total_(total_messages), interval_s_(interval_s), wall_start_(std::chrono::steady_clock::now()),
+      wall_last_print_(wall_start_) {}
+
+  void tick(double t_sim, profiler::timestamp_t calculation_time_us) {
+    ++processed_;
+    if (t_sim_begin_ == std::numeric_limits<double>::infinity())
+      t_sim_begin_ = t_sim;
+    if ((processed_ & 0x3FF) != 0)
+      return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - wall_last_print_).count() < interval_s_)
+      return;
+    wall_last_print_ = now;
+
+    double wall_passed = std::chrono::duration<double>(now - wall_start_).count();
+    double percent = total_ > 0 ? 100.0 * static_cast<double>(processed_) / static_cast<double>(total_) : 0.0;
+    double eta = processed_ > 0 ? wall_passed * static_cast<double>(total_ - processed_)
+                                  / static_cast<double>(processed_) : 0.0;
+    double t_sim_passed = t_sim - t_sim_begin_;
+    double rt_factor = t_sim_passed > 0 ? calculation_time_us * 1e-6 / t_sim_passed : 0.0;
+
+    std::cerr << std::fixed << std::setprecision(1)
+              << "progress: " << percent << "% (" << processed_ << "/" << total_ << " msgs)"
+              << " | rt factor " << std::setprecision(2) << rt_factor
+              << " | ETA " << std::setprecision(0) << eta << "s"
+              << std::defaultfloat << std::setprecision(6) << std::endl;
+  }
 
+ private:
+  size_t total_;
+  size_t processed_ = 0;
+  double interval_s_;
+  double t_sim_begin_ = std::numeric_limits<double>::infinity();
+  std::chrono::steady_clock::time_point wall_start_, wall_last_print_;
+};
 
-  std::cerr << "Reading rosbag '" << FLAGS_input_bag << "'" << std::endl;
-  rosbag::Bag bag;
-  bag.open(FLAGS_input_bag);  // BagMode is Read by default
+/**
+ * Classifies and instantiates bag messages, independent of any particular frontend, so one decode pass can feed
+ * several consumers. decode_events controls whether event arrays are deserialized at all (frontends that do not
+ * process events keep skipping that cost). When params is given, images are additionally run through cv_bridge and
+ * x::TiledImage construction right here -- with a prefetch window this happens on the reader thread, overlapping
+ * image decode with VIO compute instead of stalling kHz IMU processing at every frame.
+ */
+class MessageDecoder {
+ public:
+  MessageDecoder(const EvalJob &job, bool decode_events, const x::Params *params = nullptr)
+    : job_(job), decode_events_(decode_events), params_(params) {}
+
+  /**
+   * Connection-indexed topic classification: rosbag hands out the topic as a reference into the per-connection
+   * ConnectionInfo, so the string's address identifies the connection. After the first message of each connection the
+   * per-message cost is a scan over a handful of pointers instead of up to four std::string comparisons. New handler
+   * kinds (range, sun sensor, ...) only need a new MsgKind and a branch below.
+   */
+  MsgKind classifyTopic(const std::string &topic) {
+    for (const auto &entry : topic_dispatch_)
+      if (entry.first == &topic)
+        return entry.second;
+
+    MsgKind kind = MsgKind::IGNORE;
+    if (topic == job_.imu_topic)
+      kind = MsgKind::IMU;
+    else if (topic == job_.image_topic)
+      kind = MsgKind::IMAGE;
+    else if (decode_events_ && !job_.events_topic.empty() && topic == job_.events_topic)
+      kind = MsgKind::EVENTS;
+    else if (!job_.pose_topic.empty() && topic == job_.pose_topic)
+      kind = MsgKind::GT_POSE;
+
+    topic_dispatch_.emplace_back(&topic, kind);
+    return kind;
+  }
 
-  vio.setUp(params);
+  PrefetchedMessage decodeMessage(const rosbag::MessageInstance &m) {
+    PrefetchedMessage msg;
+    msg.t_bag = m.getTime().toSec();
+    msg.kind = classifyTopic(m.getTopic());
+
+    switch (msg.kind) {
+      case MsgKind::IMU:
+        msg.imu = m.instantiate<sensor_msgs::Imu>();
+        break;
+      case MsgKind::IMAGE:
+        msg.image = m.instantiate<sensor_msgs::Image>();
+        if (params_ != nullptr && msg.image) {
+          auto tiled = std::make_shared<x::TiledImage>();
+          if (msgToTiledImage(*params_, msg.image, *tiled))
+            msg.tiled_image = std::move(tiled);
+        }
+        break;
+      case MsgKind::EVENTS:
+        msg.events = m.instantiate<dvs_msgs::EventArray>();
+        break;
+      case MsgKind::GT_POSE:
+        if (m.isType<geometry_msgs::PoseStamped>()) {
+          msg.gt_pose = m.instantiate<geometry_msgs::PoseStamped>();
+        } else if (m.isType<geometry_msgs::PoseWithCovarianceStamped>()) {
+          msg.gt_pose_cov = m.instantiate<geometry_msgs::PoseWithCovarianceStamped>();
+        } else if (m.isType<tf2_msgs::TFMessage>()) {
+          msg.gt_tf = m.instantiate<tf2_msgs::TFMessage>();
+        } else {
+          std::cerr << "WARNING: unable to type of GT message: " << m.getTopic() << std::endl;
+          msg.kind = MsgKind::IGNORE;
+        }
+        break;
+      default:
+        break;
+    }
+    return msg;
+  }
 
-  auto from = ros::TIME_MIN;
-  auto to = ros::TIME_MAX;
+ private:
+  const EvalJob &job_;
+  bool decode_events_;
+  const x::Params *params_;  // when set, images are decoded to x::TiledImage in the decoder stage
+  std::vector<std::pair<const std::string *, MsgKind>> topic_dispatch_;  // connection --> handler
+};
 
-  // if initialized differently from default values
-  if (FLAGS_from > std::numeric_limits<double>::min())
-    from = ros::Time(FLAGS_from);
-  if (FLAGS_to < std::numeric_limits<double>::max())
-    to = ros::Time(FLAGS_to);
+/**
+ * One full evaluation of a VIO frontend on a sequence. The per-modality handlers are shared between the rosbag replay
+ * path and the pre-decoded cache replay path (--input_cache), so all bookkeeping (CSV logging, resource sampling,
+ * debug flushing, progress) behaves identically no matter where the messages come from.
+ *
+ * Templated on the VIO type: single-job mode instantiates with the concrete frontend class, so processImu() -- hit at
+ * kHz rates -- is a direct, inlinable call instead of virtual dispatch through x::AbstractVio. The multi-frontend
+ * modes keep using the EvaluationRun<x::AbstractVio> instantiation, where calls stay virtual as before.
+ */
+template <class Vio>
+class EvaluationRun {
+ public:
+  EvaluationRun(Vio &vio, const fs::path &output_path, const x::Params &params, const EvalJob &job)
+    : vio_(vio), output_path_(output_path), params_(params), job_(job) {
+    bool resuming = !job.resume_from.empty();
+    if (resuming) {
+      // NOTE: only the harness-side progress is restored here; the x::AbstractVio interface offers no filter state
+      // serialization (yet), so the filter re-initializes at the checkpoint time and re-converges from there.
+      YAML::Node checkpoint = YAML::LoadFile(job.resume_from);
+      resume_t_ = checkpoint["t_sim"].as<double>();
+      calculation_time_ = checkpoint["calculation_time_us"].as<profiler::timestamp_t>();
+      counter_imu_ = checkpoint["counter_imu"].as<uint64_t>();
+      counter_image_ = checkpoint["counter_image"].as<uint64_t>();
+      counter_events_ = checkpoint["counter_events"].as<uint64_t>();
+      counter_pose_ = checkpoint["counter_pose"].as<uint64_t>();
+      std::cerr << "Resuming from checkpoint at t_sim " << std::setprecision(17) << resume_t_ << std::endl;
+    }
 
-  rosbag::View view(bag, from, to);
+    pose_csv_ = x_evaluate::makeRowSink<std::string, double, double, double, double, double, double, double, double>(
+      job.binary_outputs, job.async_logging, (output_path / "pose.csv").string(),
+      {"update_modality", "t",
+       "estimated_p_x", "estimated_p_y", "estimated_p_z",
+       "estimated_q_x", "estimated_q_y", "estimated_q_z", "estimated_q_w"}, resuming, job.metrics_only);
+    imu_bias_csv_ = x_evaluate::makeRowSink<double, double, double, double, double, double, double,
+                                            double, double, double, double, double, double>(
+      job.binary_outputs, job.async_logging, (output_path / "imu_bias.csv").string(),
+      {"t", "b_a_x", "b_a_y", "b_a_z", "b_w_x", "b_w_y", "b_w_z",
+       "sigma_b_a_x", "sigma_b_a_y", "sigma_b_a_z", "sigma_b_w_x", "sigma_b_w_y", "sigma_b_w_z"}, resuming, job.metrics_only);
+    rt_csv_ = x_evaluate::makeRowSink<double, double, profiler::timestamp_t, std::string, profiler::timestamp_t>(
+      job.binary_outputs, job.async_logging, (output_path / "realtime.csv").string(),
+      {"t_sim", "t_real", "ts_real", "processing_type", "process_time_in_us"}, resuming, job.metrics_only);
+    resource_csv_ = x_evaluate::makeRowSink<profiler::timestamp_t, double, double, double, size_t, size_t>(
+      job.binary_outputs, job.async_logging, (output_path / "resource.csv").string(),
+      {"ts", "cpu_usage", "cpu_user_mode_usage", "cpu_kernel_mode_usage", "memory_usage_in_bytes", "debug_memory_in_bytes"}, resuming, job.metrics_only);
+    resource_threads_csv_ = x_evaluate::makeRowSink<profiler::timestamp_t, uint64_t, std::string, double, double>(
+      job.binary_outputs, job.async_logging, (output_path / "resource_threads.csv").string(),
+      {"ts", "tid", "thread_name", "cpu_user_mode_usage", "cpu_kernel_mode_usage"}, resuming, job.metrics_only);
+    resource_sampler_.reset(new x_evaluate::ResourceSampler(
+      *resource_csv_, *resource_threads_csv_,
+      [] { return x::DebugMemoryMonitor::instance().memory_usage_in_bytes(); },
+      job.resource_sampling_interval_s));
+    if (!job.pose_topic.empty()) {
+      gt_csv_ = x_evaluate::makeRowSink<double, double, double, double, double, double, double, double>(
+        job.binary_outputs, job.async_logging, (output_path / "gt.csv").string(),
+        {"t", "p_x", "p_y", "p_z", "q_x", "q_y", "q_z", "q_w"}, resuming, job.metrics_only);
+      gt_batch_.reserve(kGtBatchRows);
+    }
+    if (job.compressed_frame_dump && (job.dump_input_frames || job.dump_debug_frames))
+      frame_dump_.reset(new x_evaluate::FrameDumpSink((output_path / "frames.xfd").string()));
+    if (job.perf_counters)
+      perf_counters_.reset(new x_evaluate::PerfCounters());  // before setUp(), so worker threads are inherited
+    if (job.metrics || job.metrics_only)
+      metrics_.reset(new x_evaluate::TrajectoryMetrics());
+  }
 
-  std::cerr << "Initializing at time " << std::setprecision(17) << view.getBeginTime().toSec() << std::endl;
-  vio.initAtTime(view.getBeginTime().toSec());
+  /// Replay errors (bad bag, truncated cache, ...) propagate past finish(); the worker must still be joined here,
+  /// or destroying the joinable thread terminates the process and a single failed job kills the whole sweep.
+  ~EvaluationRun() { stopDebugFlushWorker(); }
+
+  int replayBag() {
+    std::cerr << "Reading rosbag '" << job_.input_bag << "'" << std::endl;
+    rosbag::Bag bag;
+    bag.open(job_.input_bag);  // BagMode is Read by default
+
+    auto from = ros::TIME_MIN;
+    auto to = ros::TIME_MAX;
+
+    // if initialized differently from default values
+    if (job_.from > std::numeric_limits<double>::min())
+      from = ros::Time(job_.from);
+    if (job_.to < std::numeric_limits<double>::max())
+      to = ros::Time(job_.to);
+    if (resume_t_ > 0.0)
+      from = ros::Time(resume_t_ + 1e-6);  // checkpointed message itself was already processed
+
+    rosbag::View view(bag, from, to);
+
+    start(view.getBeginTime().toSec(), view.size());
+
+    std::cerr << "Processing rosbag from time " << view.getBeginTime() << " to " << view.getEndTime()
+              << std::endl << std::endl;
+
+    MessageDecoder decoder(job_, vio_.doesProcessEvents(), &params_);
+
+    if (job_.prefetch_window > 0) {
+      // double-buffered prefetch: reader thread walks the view and instantiates messages a bounded window ahead
+      x_evaluate::BoundedQueue<PrefetchedMessage> queue(job_.prefetch_window);
+      std::exception_ptr reader_error;
+      std::thread reader([&view, &queue, &decoder, &reader_error] {
+        try {
+          for (rosbag::MessageInstance const &m : view)
+            if (!queue.push(decoder.decodeMessage(m)))
+              break;
+        } catch (...) {
+          reader_error = std::current_exception();  // e.g. rosbag instantiate on a corrupt bag; rethrown after join
+        }
+        queue.close();
+      });
+
+      try {
+        PrefetchedMessage msg;
+        while (!aborted_ && queue.pop(msg))
+          dispatchMessage(msg);
+      } catch (...) {
+        queue.cancel();  // unblock and stop the reader before unwinding destroys the joinable thread
+        reader.join();
+        throw;
+      }
+      queue.cancel();
+      reader.join();
+      if (reader_error)
+        std::rethrow_exception(reader_error);  // fail this job through the normal per-job error handling
+    } else {
+      for (rosbag::MessageInstance const &m : view) {
+        PrefetchedMessage msg = decoder.decodeMessage(m);
+        dispatchMessage(msg);
+        if (aborted_)
+          break;
+      }
+    }
 
-  std::cerr << "Processing rosbag from time " << view.getBeginTime() << " to " << view.getEndTime()
-            << std::endl << std::endl;
+    bag.close();
+    return 0;
+  }
 
-  uint64_t counter_imu = 0, counter_image = 0, counter_events = 0, counter_pose = 0;
-  bool filer_initialized = false;
+  x::EventArray::Ptr convertEvents(const dvs_msgs::EventArrayConstPtr &events_msg_ptr) {
+    if (job_.batched_event_conversion) {
+      x_evaluate::convertEventsSoA(*events_msg_ptr, event_batch_);
 
-  x::State state;
-  auto t_0 = std::numeric_limits<double>::infinity();
-  auto t_last_flush = std::numeric_limits<double>::infinity();
-  boost::progress_display show_progress(view.size(), std::cerr);
+      x::EventArray::Ptr x_events;
+      if (job_.pooled_events) {
+        x_events = event_pool_.acquire();
+        x_events->seq = events_msg_ptr->header.seq;
+        x_events->height = events_msg_ptr->height;
+        x_events->width = events_msg_ptr->width;
+      } else {
+        x_events.reset(new x::EventArray(events_msg_ptr->header.seq, events_msg_ptr->height,
+                                         events_msg_ptr->width, {}));
+      }
+      x_evaluate::soaToEventList(event_batch_, x_events->events);
+      return x_events;
+    }
+    if (job_.pooled_events)
+      return x_evaluate::msgToEventsPooled(event_pool_, events_msg_ptr);
+    return msgToEvents(events_msg_ptr);
+  }
 
-  profiler::timestamp_t calculation_time = 0, last_rusage_check = 0;
+  bool aborted() const { return aborted_; }
+
+  void dispatchMessage(const PrefetchedMessage &msg) {
+    if (aborted_)
+      return;
+    paceReplay(msg.t_bag);
+    switch (msg.kind) {
+      case MsgKind::IMU: {
+        auto start_ts = profiler::now();
+        handleImu(msg.t_bag, msg.imu->header.stamp.toSec(), msg.imu->header.seq,
+                  msgVector3ToEigen(msg.imu->angular_velocity), msgVector3ToEigen(msg.imu->linear_acceleration),
+                  start_ts);
+        break;
+      }
+      case MsgKind::IMAGE:
+        handleImage(msg.t_bag, msg.image, msg.tiled_image);
+        break;
+      case MsgKind::EVENTS: {
+        if (!vio_.doesProcessEvents() || job_.events_topic.empty()) {
+          finishMessage(MsgKind::IGNORE, msg.t_bag, 0, 0);
+          break;
+        }
+        auto start_ts = profiler::now();
+        if (rechunkingEnabled())
+          rechunkEvents(msg.t_bag, convertEvents(msg.events));
+        else
+          handleEvents(msg.t_bag, convertEvents(msg.events), start_ts);
+        break;
+      }
+      case MsgKind::GT_POSE: {
+        EASY_BLOCK("GT Message");
+        if (msg.gt_pose) {
+          const auto &p = msg.gt_pose;
+          addGtRow(p->header.stamp.toSec(), p->pose.position.x, p->pose.position.y, p->pose.position.z,
+                   p->pose.orientation.x, p->pose.orientation.y, p->pose.orientation.z, p->pose.orientation.w);
+        } else if (msg.gt_pose_cov) {
+          const auto &p = msg.gt_pose_cov->pose.pose;
+          addGtRow(msg.gt_pose_cov->header.stamp.toSec(), p.position.x, p.position.y, p.position.z,
+                   p.orientation.x, p.orientation.y, p.orientation.z, p.orientation.w);
+        } else if (msg.gt_tf) {
+          for (const auto &p : msg.gt_tf->transforms) {
+            if (!job_.gt_child_frame.empty() && p.child_frame_id != job_.gt_child_frame)
+              continue;
+            addGtRow(p.header.stamp.toSec(), p.transform.translation.x, p.transform.translation.y, p.transform.translation.z,
+                     p.transform.rotation.x, p.transform.rotation.y, p.transform.rotation.z, p.transform.rotation.w);
+          }
+        }
+        EASY_END_BLOCK;
+        finishMessage(MsgKind::IGNORE, msg.t_bag, 0, 0);
+        break;
+      }
+      default:
+        finishMessage(MsgKind::IGNORE, msg.t_bag, 0, 0);
+        break;
+    }
+  }
 
-  struct timeval rusage_walltime;
-  gettimeofday(&rusage_walltime, nullptr);
+  /// Replays an in-memory decoded message vector (resident sweep mode) -- no bag or cache I/O at all.
+  int replayMessages(const std::vector<PrefetchedMessage> &messages, double t_begin) {
+    start(t_begin, messages.size());
 
-  struct rusage prev_rusage;
-  getrusage(RUSAGE_SELF, &prev_rusage);
+    for (const auto &msg : messages) {
+      dispatchMessage(msg);
+      if (aborted_)
+        break;
+    }
+    return 0;
+  }
 
+  int replayCache() {
+    std::cerr << "Replaying pre-decoded cache '" << job_.input_cache << "'" << std::endl;
+    x_evaluate::BagCacheReader reader(job_.input_cache);
+
+    double from = resume_t_ > 0.0 ? resume_t_ + 1e-6 : job_.from;
+    double t_begin = std::max(reader.header().t_begin, from);
+    start(t_begin, reader.header().num_records);
+
+    std::cerr << "Processing cache from time " << std::setprecision(17) << t_begin << " to "
+              << std::min(reader.header().t_end, job_.to) << std::endl << std::endl;
+
+    reader.forEach(from, job_.to, [this](const x_evaluate::BagCacheReader::Record &rec) -> bool {
+      paceReplay(rec.t_bag);
+      switch (rec.kind) {
+        case MsgKind::IMU: {
+          x_evaluate::CachedImu imu {};
+          std::memcpy(&imu, rec.payload, sizeof imu);
+          handleImu(rec.t_bag, imu.t, imu.seq, x::Vector3{imu.w[0], imu.w[1], imu.w[2]},
+                    x::Vector3{imu.a[0], imu.a[1], imu.a[2]}, profiler::now());
+          break;
+        }
+        case MsgKind::IMAGE: {
+          x_evaluate::CachedImageHeader hdr {};
+          std::memcpy(&hdr, rec.payload, sizeof hdr);
+          auto msg = boost::make_shared<sensor_msgs::Image>();
+          msg->header.stamp = ros::Time(hdr.t);
+          msg->header.seq = hdr.seq;
+          msg->height = hdr.height;
+          msg->width = hdr.width;
+          msg->step = hdr.step;
+          msg->encoding = hdr.encoding;
+          msg->data.assign(rec.payload + sizeof hdr, rec.payload + sizeof hdr + hdr.data_size);
+          handleImage(rec.t_bag, msg, nullptr);
+          break;
+        }
+        case MsgKind::EVENTS: {
+          if (!vio_.doesProcessEvents() || job_.events_topic.empty()) {
+            finishMessage(MsgKind::IGNORE, rec.t_bag, 0, 0);
+            break;
+          }
+          x_evaluate::CachedEventsHeader hdr {};
+          std::memcpy(&hdr, rec.payload, sizeof hdr);
+          x::EventArray::Ptr x_events;
+          if (job_.pooled_events) {
+            x_events = event_pool_.acquire();
+            x_events->seq = hdr.seq;
+            x_events->height = hdr.height;
+            x_events->width = hdr.width;
+            x_events->events.clear();
+          } else {
+            x_events.reset(new x::EventArray(hdr.seq, hdr.height, hdr.width, {}));
+          }
+          auto &event_list = x_events->events;
+          event_list.reserve(hdr.num_events);
+          const uint8_t *p = rec.payload + sizeof hdr;
+          for (uint64_t i = 0; i < hdr.num_events; ++i, p += sizeof(x_evaluate::CachedEvent)) {
+            x_evaluate::CachedEvent e {};
+            std::memcpy(&e, p, sizeof e);
+            event_list.emplace_back(e.x, e.y, e.t, e.polarity);
+          }
+          if (rechunkingEnabled())
+            rechunkEvents(rec.t_bag, x_events);
+          else
+            handleEvents(rec.t_bag, x_events, profiler::now());
+          break;
+        }
+        case MsgKind::GT_POSE: {
+          if (!gt_csv_) {
+            finishMessage(MsgKind::IGNORE, rec.t_bag, 0, 0);
+            break;
+          }
+          x_evaluate::CachedPose pose {};
+          std::memcpy(&pose, rec.payload, sizeof pose);
+          EASY_BLOCK("GT Message");
+          addGtRow(pose.t, pose.p[0], pose.p[1], pose.p[2], pose.q[0], pose.q[1], pose.q[2], pose.q[3]);
+          EASY_END_BLOCK;
+          finishMessage(MsgKind::IGNORE, rec.t_bag, 0, 0);
+          break;
+        }
+        default:
+          finishMessage(MsgKind::IGNORE, rec.t_bag, 0, 0);
+          break;
+      }
+      return !aborted_;
+    });
 
-  EASY_PROFILER_ENABLE;
-  EASY_MAIN_THREAD;
+    return 0;
+  }
 
-  for (rosbag::MessageInstance const &m : view) {
+  void finish() {
+    if (!pending_events_.empty() && !aborted_) {
+      emitEventBatch(0, pending_events_.size());  // partial tail batch of the re-chunking stage
+      pending_events_.clear();
+    }
 
-    std::string process_type;
+    resource_sampler_->stop();  // sampler owns the resource sinks while running --> stop before flushing them
+    stopDebugFlushWorker();
 
-    auto start = profiler::now();
+    if (job_.enable_profiling) {
+      if (job_.profiling_segment_s > 0)
+        dumpProfilingSegment();  // remaining tail of the last window
+      else
+        profiler::dumpBlocksToFile((output_path_ / "profiling.prof").c_str());
+//    JsonExporter je;
+//    je.convert((output_path_ / "profiling.prof").c_str(), (output_path_ / "profiling.json").c_str());
+    }
 
-    if (m.getTopic() == FLAGS_imu_topic) {
-      process_type = "IMU";
-      auto msg = m.instantiate<sensor_msgs::Imu>();
-      ++counter_imu;
+    std::cerr << "Processed " << counter_imu_ << " IMU, "
+              << counter_image_ << " image, "
+              << counter_events_ << " event and "
+              << counter_pose_ << " pose messages" << std::endl;
+
+    std::cerr << "Writing outputs to folder " << output_path_ << std::endl;
+
+    writeLatencySummary();
+    writeRunSummary();
+    if (metrics_)
+      writeMetrics();
+    if (perf_counters_ && perf_counters_->available())
+      writePerfCounters();
+
+    // manually flush to ensure files are dumped even in case of memory corruption (double-free in destructors etc.)
+    pose_csv_->flush();
+    imu_bias_csv_->flush();
+    rt_csv_->flush();
+    resource_csv_->flush();
+    resource_threads_csv_->flush();
+    if (gt_csv_) {
+      flushGtRows();
+      gt_csv_->flush();
+    }
+    if (frame_dump_) {
+      frame_dump_->close();
+      std::cerr << "Dumped " << frame_dump_->numFrames() << " frames to frames.xfd" << std::endl;
+    }
+    x::DebugMemoryMonitor::instance().flush_all();
 
-      // count what would end up in ros callback
-      EASY_BLOCK("IMU Message");
+    std::cerr << "Evaluation completed " << get_time_string_in_utc();
+    std::cerr << "Good bye!" << std::endl;
+  }
 
-      auto a_m = msgVector3ToEigen(msg->linear_acceleration);
-      auto w_m = msgVector3ToEigen(msg->angular_velocity);
+  void start(double t_begin, size_t total_messages) {
+    vio_.setUp(params_);
+    std::cerr << "Initializing at time " << std::setprecision(17) << t_begin << std::endl;
+    vio_.initAtTime(t_begin);
+
+    if (job_.show_progress)
+      show_progress_.reset(new ProgressReporter(total_messages));
+
+    resource_sampler_->start();
+
+    // periodic DebugMemoryMonitor flushes run on their own thread; the monitor is already written to from frontend
+    // worker threads, so its writers are synchronized -- the harness only moves the disk I/O off the hot loop here.
+    // Buffer swapping inside the monitor itself would be the cleaner fix, but that lives in the x library.
+    debug_flush_worker_ = std::thread([this] {
+      std::unique_lock<std::mutex> lock(debug_flush_mutex_);
+      while (true) {
+        debug_flush_cv_.wait(lock, [this] { return debug_flush_requested_ || debug_flush_done_; });
+        if (debug_flush_done_)
+          break;
+        debug_flush_requested_ = false;
+        lock.unlock();
+        x::DebugMemoryMonitor::instance().flush_all();
+        lock.lock();
+      }
+    });
 
-      state = vio.processImu(msg->header.stamp.toSec(), msg->header.seq, w_m, a_m);
-      EASY_END_BLOCK;
+    if (job_.enable_profiling) {
+      EASY_PROFILER_ENABLE;
+      EASY_MAIN_THREAD;
+    }
 
-    } else if (m.getTopic() == FLAGS_image_topic) {
-      process_type = "Image";
-      auto msg = m.instantiate<sensor_msgs::Image>();
-      ++counter_image;
+    // the virtual clock starts after setUp(), so frontend construction cost does not eat into the release schedule
+    replay_t_begin_ = t_begin;
+    replay_wall_start_ = std::chrono::steady_clock::now();
+  }
 
-      EASY_BLOCK("Image Message");
-      x::TiledImage image;
-      if (!msgToTiledImage(params, msg, image))
-        continue;
+ private:
+  /// Idempotent: called from finish() on the normal path and from the destructor when a replay error unwinds.
+  void stopDebugFlushWorker() {
+    if (!debug_flush_worker_.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(debug_flush_mutex_);
+      debug_flush_done_ = true;
+    }
+    debug_flush_cv_.notify_one();
+    debug_flush_worker_.join();
+  }
 
-      if (image.rows != params.img_height || image.cols != params.img_width) {
-        std::cerr << "CRITICAL ERROR: image width different height / width encountered: " << image.cols << "x"
-                  << image.rows << ", expected: " << params.img_width << "x" << params.img_height
-                  << " --> SKIPPING IMAGE" << std::endl;
-        continue;
-      }
+  /**
+   * Virtual-clock pacing (--replay_factor): each message is released at its bag timestamp mapped onto the wall
+   * clock, scaled by the configured factor. Deadlines are absolute (computed from the bag time, not from "now"),
+   * so processing jitter does not accumulate into drift and the arrival pattern is reproducible across runs --
+   * as-fast-as-possible replay gives the internal worker threads of EKLT/HASTE unrealistically favorable
+   * scheduling and makes realtime.csv numbers vary run to run. A message that finishes after its successor's
+   * deadline simply releases the successor immediately (sleep_until with a past deadline), as a live source would.
+   */
+  void paceReplay(double t_bag) {
+    if (job_.replay_factor <= 0.0)
+      return;
+    auto offset = std::chrono::duration<double>((t_bag - replay_t_begin_) / job_.replay_factor);
+    std::this_thread::sleep_until(
+      replay_wall_start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+  }
 
-      x::TiledImage feature_img(image);
-      state = vio.processImageMeasurement(image.getTimestamp(), image.getFrameNumber(), image, feature_img);
-      EASY_END_BLOCK;
+  void handleImu(double t_bag, double t, uint32_t seq, const x::Vector3 &w_m, const x::Vector3 &a_m,
+                 profiler::timestamp_t start_ts) {
+    ++counter_imu_;
 
-    } else if (vio.doesProcessEvents() && !FLAGS_events_topic.empty() && m.getTopic() == FLAGS_events_topic) {
-      process_type = "Events";
-      auto msg = m.instantiate<dvs_msgs::EventArray>();
-      ++counter_events;
+    auto perf_before = perfSnapshot();
 
-      EASY_BLOCK("Events Message");
-      x::EventArray::Ptr x_events = msgToEvents(msg);
+    // count what would end up in ros callback
+    EASY_BLOCK("IMU Message");
+    state_.capture(vio_.processImu(t, seq, w_m, a_m));
+    EASY_END_BLOCK;
 
-      x::TiledImage tracker_img, feature_img;
-      state = vio.processEventsMeasurement(x_events, tracker_img, feature_img);
-      EASY_END_BLOCK;
+    perfAccumulate(MsgKind::IMU, perf_before);
+    finishMessage(MsgKind::IMU, t_bag, start_ts, profiler::now());
+  }
 
-    } else if (!FLAGS_pose_topic.empty() && m.getTopic() == FLAGS_pose_topic) {
-      EASY_BLOCK("GT Message");
-      if (m.isType<geometry_msgs::PoseStamped>()) {
-        auto p = m.instantiate<geometry_msgs::PoseStamped>();
-        ++counter_pose;
-        gt_csv->addRow(p->header.stamp.toSec(), p->pose.position.x, p->pose.position.y, p->pose.position.z,
-                       p->pose.orientation.x, p->pose.orientation.y, p->pose.orientation.z, p->pose.orientation.w);
-      } else if (m.isType<tf2_msgs::TFMessage>()) {
-        auto tf = m.instantiate<tf2_msgs::TFMessage>();
-        for (const auto & p : tf->transforms) {
-          ++counter_pose;
-          gt_csv->addRow(p.header.stamp.toSec(), p.transform.translation.x, p.transform.translation.y, p.transform.translation.z,
-                         p.transform.rotation.x, p.transform.rotation.y, p.transform.rotation.z, p.transform.rotation.w);
-        }
+  void handleImage(double t_bag, const sensor_msgs::ImageConstPtr &msg,
+                   const std::shared_ptr<x::TiledImage> &pre_decoded) {
+    ++counter_image_;
 
+    x::TiledImage image;
+    if (pre_decoded) {
+      if (job_.deep_copy_images) {
+        // other runs see the same decoded mat and the VIO may draw into its input --> detach the pixel buffer
+        image = x::TiledImage(pre_decoded->clone(), pre_decoded->getTimestamp(), pre_decoded->getFrameNumber(),
+                              params_.n_tiles_h, params_.n_tiles_w, params_.max_feat_per_tile);
       } else {
-        std::cerr << "WARNING: unable to type of GT message: " << m.getTopic() << std::endl;
+        image = *pre_decoded;  // shallow cv::Mat copy, pixel data stays shared with the decoder stage
       }
+    } else {
+      EASY_BLOCK("Image Decode");
+      if (!msgToTiledImage(params_, msg, image, job_.deep_copy_images))
+        return;
       EASY_END_BLOCK;
     }
 
-    // stop here --> all the rest is not considered
-    auto stop = profiler::now();
+    if (image.rows != params_.img_height || image.cols != params_.img_width) {
+      std::cerr << "CRITICAL ERROR: image width different height / width encountered: " << image.cols << "x"
+                << image.rows << ", expected: " << params_.img_width << "x" << params_.img_height
+                << " --> SKIPPING IMAGE" << std::endl;
+      return;
+    }
+
+    // "Image" rows in realtime.csv attribute the VIO call only -- decode cost lives in the decoder stage
+    auto start_ts = profiler::now();
+    auto perf_before = perfSnapshot();
+    EASY_BLOCK("Image Message");
+    x::TiledImage feature_img(image);
+    state_.capture(vio_.processImageMeasurement(image.getTimestamp(), image.getFrameNumber(), image, feature_img));
+    EASY_END_BLOCK;
+    perfAccumulate(MsgKind::IMAGE, perf_before);
+
+    auto stop_ts = profiler::now();
+    if (frame_dump_) {
+      if (job_.dump_input_frames)
+        frame_dump_->addFrame(image.getTimestamp(), "input_img", image);
+      if (job_.dump_debug_frames)
+        frame_dump_->addFrame(image.getTimestamp(), "feature_img", feature_img);
+    }
 
-    if (m.getTime().toSec() < t_0)
-      t_0 = m.getTime().toSec();
+    finishMessage(MsgKind::IMAGE, t_bag, start_ts, stop_ts);
+  }
 
-    if (m.getTime().toSec() < t_last_flush)  // initialization
-      t_last_flush = m.getTime().toSec();
+  x_evaluate::PerfCounters::Sample perfSnapshot() const {
+    return perf_counters_ && perf_counters_->available() ? perf_counters_->read()
+                                                         : x_evaluate::PerfCounters::Sample {};
+  }
+
+  void perfAccumulate(MsgKind kind, const x_evaluate::PerfCounters::Sample &before) {
+    if (perf_counters_ && perf_counters_->available())
+      perf_totals_[static_cast<size_t>(kind)] += perf_counters_->read() - before;
+  }
 
-    if (m.getTime().toSec() - t_last_flush > 5.0) {
-      t_last_flush = m.getTime().toSec();
-      x::DebugMemoryMonitor::instance().flush_all();
+  /// Per-modality hardware counter totals next to realtime.csv -- shows e.g. cache-miss-bound slowdowns that
+  /// wall time alone cannot distinguish from plain extra work.
+  void writePerfCounters() {
+    x::CsvWriter<std::string, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t> csv(
+      (output_path_ / "perf_counters.csv").string(),
+      {"process_type", "messages", "instructions", "cycles", "cache_misses", "branch_misses"});
+    const uint64_t counts[] = {counter_imu_, counter_image_, counter_events_};
+    for (auto kind : {MsgKind::IMU, MsgKind::IMAGE, MsgKind::EVENTS}) {
+      const auto &total = perf_totals_[static_cast<size_t>(kind)];
+      csv.addRow(msgKindName(kind), counts[static_cast<size_t>(kind)],
+                 total.instructions, total.cycles, total.cache_misses, total.branch_misses);
     }
+  }
 
-//    // profile 1s only to avoid huge files that are not handleable anymore
-//    if (m.getTime().toSec() - t_0 > 1.0)
-//      EASY_PROFILER_DISABLE;
+  /// Coalescing hand-off to the flush worker: if a flush is still in flight, the request merges into it.
+  void requestDebugFlush() {
+    {
+      std::lock_guard<std::mutex> lock(debug_flush_mutex_);
+      debug_flush_requested_ = true;
+    }
+    debug_flush_cv_.notify_one();
+  }
 
-    if (calculation_time - last_rusage_check >= 1000000) {
-      last_rusage_check = calculation_time;
-      struct timeval rusage_walltime_new;
-      gettimeofday(&rusage_walltime_new, nullptr);
+  bool rechunkingEnabled() const { return job_.event_batch_size > 0 || job_.event_batch_dt > 0; }
+
+  /**
+   * Re-chunks the converted event stream to --event_batch_size events and/or --event_batch_dt seconds per
+   * processEventsMeasurement() call, independent of the EventArray sizes the recorder happened to use. Timestamps
+   * are untouched, only the batch boundaries move; a partial tail batch is flushed at the end of the run.
+   */
+  void rechunkEvents(double t_bag, const x::EventArray::Ptr &x_events) {
+    last_events_t_bag_ = t_bag;
+    if (pending_events_.empty()) {
+      pending_height_ = x_events->height;
+      pending_width_ = x_events->width;
+    }
+    pending_events_.insert(pending_events_.end(), x_events->events.begin(), x_events->events.end());
+
+    size_t begin = 0;
+    while (begin < pending_events_.size() && !aborted_) {
+      size_t available = pending_events_.size() - begin;
+      size_t take = 0;
+      if (job_.event_batch_size > 0 && available >= job_.event_batch_size) {
+        take = job_.event_batch_size;
+      } else if (job_.event_batch_dt > 0 &&
+                 pending_events_.back().ts - pending_events_[begin].ts >= job_.event_batch_dt) {
+        double t_limit = pending_events_[begin].ts + job_.event_batch_dt;
+        while (take < available && pending_events_[begin + take].ts < t_limit)
+          ++take;
+      }
+      if (take == 0)
+        break;
+      emitEventBatch(begin, take);
+      begin += take;
+    }
+    pending_events_.erase(pending_events_.begin(), pending_events_.begin() + static_cast<ptrdiff_t>(begin));
+  }
 
-      double walltime_sec_passed = (rusage_walltime_new.tv_sec + rusage_walltime_new.tv_usec * 1e-6) -
-                                 (rusage_walltime.tv_sec + rusage_walltime.tv_usec * 1e-6);
+  void emitEventBatch(size_t begin, size_t count) {
+    auto first = pending_events_.begin() + static_cast<ptrdiff_t>(begin);
+    auto last = first + static_cast<ptrdiff_t>(count);
+    x::EventArray::Ptr chunk;
+    if (job_.pooled_events) {
+      // recycled storage --> the re-chunking stage stays allocation-free once the pool buffers are warm
+      chunk = event_pool_.acquire();
+      chunk->seq = rechunk_seq_++;
+      chunk->height = pending_height_;
+      chunk->width = pending_width_;
+      chunk->events.assign(first, last);
+    } else {
+      chunk.reset(new x::EventArray(rechunk_seq_++, pending_height_, pending_width_, std::vector<x::Event>(first, last)));
+    }
+    handleEvents(last_events_t_bag_, chunk, profiler::now());
+  }
 
-      struct rusage cur_rusage;
-      getrusage(RUSAGE_SELF, &cur_rusage);
+  void handleEvents(double t_bag, const x::EventArray::Ptr &x_events, profiler::timestamp_t start_ts) {
+    ++counter_events_;
+
+    auto perf_before = perfSnapshot();
+    EASY_BLOCK("Events Message");
+    x::TiledImage tracker_img, feature_img;
+    state_.capture(vio_.processEventsMeasurement(x_events, tracker_img, feature_img));
+    EASY_END_BLOCK;
+    perfAccumulate(MsgKind::EVENTS, perf_before);
+
+    auto stop_ts = profiler::now();
+    if (frame_dump_ && job_.dump_debug_frames && !x_events->events.empty()) {
+      double t = x_events->events.back().ts;
+      frame_dump_->addFrame(t, "tracker_img", tracker_img);
+      frame_dump_->addFrame(t, "feature_img", feature_img);
+    }
 
-      double cpu_time_usr = (cur_rusage.ru_utime.tv_sec + cur_rusage.ru_utime.tv_usec * 1e-6) -
-                            (prev_rusage.ru_utime.tv_sec + prev_rusage.ru_utime.tv_usec * 1e-6);
-      double cpu_time_sys = (cur_rusage.ru_stime.tv_sec + cur_rusage.ru_stime.tv_usec * 1e-6) -
-                            (prev_rusage.ru_stime.tv_sec + prev_rusage.ru_stime.tv_usec * 1e-6);
+    finishMessage(MsgKind::EVENTS, t_bag, start_ts, stop_ts);
+  }
 
-//        std::cout << "timings passed: WT: " << walltime_sec_passed
-//                  << " USR: " << cpu_time_usr
-//                  << " SYS: " << cpu_time_sys << std::endl;
+  /**
+   * Ground-truth rows are staged in a preallocated buffer and handed to the sink in blocks: mocap bags broadcast
+   * /tf at 400 Hz with several transforms per message, and the per-row virtual sink call (plus, with
+   * --async_logging, a lock round-trip each) showed up next to the actual VIO work.
+   */
+  void addGtRow(double t, double p_x, double p_y, double p_z, double q_x, double q_y, double q_z, double q_w) {
+    ++counter_pose_;
+    if (metrics_)
+      metrics_->addGroundTruth(t, p_x, p_y, p_z);
+    gt_batch_.emplace_back(t, p_x, p_y, p_z, q_x, q_y, q_z, q_w);
+    if (gt_batch_.size() >= kGtBatchRows)
+      flushGtRows();
+  }
 
-      double cpu_usage = 100 * (cpu_time_sys + cpu_time_usr) / walltime_sec_passed;
-      double cpu_usage_usr = 100 * cpu_time_usr / walltime_sec_passed;
-      double cpu_usage_sys = 100 * cpu_time_sys / walltime_sec_passed;
+  void flushGtRows() {
+    if (gt_batch_.empty())
+      return;
+    gt_csv_->addRows(gt_batch_);
+    gt_batch_.clear();  // keeps its capacity --> no reallocation in steady state
+  }
 
-      size_t mem_usage_in_bytes = cur_rusage.ru_maxrss * 1024L;
-      size_t mem_usage_debug = x::DebugMemoryMonitor::instance().memory_usage_in_bytes();
+  /**
+   * Always-on compact run summary: message counts, total calculation time and the exact (undecimated) final state.
+   * Decimated pose.csv runs keep their headline numbers here without re-parsing multi-GB row files.
+   */
+  void writeRunSummary() {
+    std::ofstream out(output_path_ / "evaluation_summary.yaml");
+    out << std::setprecision(17)
+        << "counter_imu: " << counter_imu_ << "\n"
+        << "counter_image: " << counter_image_ << "\n"
+        << "counter_events: " << counter_events_ << "\n"
+        << "counter_pose: " << counter_pose_ << "\n"
+        << "calculation_time_us: " << calculation_time_ << "\n"
+        << "pose_log_decimation: " << job_.pose_log_decimation << "\n"
+        << "final_state:\n"
+        << "  t: " << state_.t << "\n"
+        << "  p: [" << state_.p_x << ", " << state_.p_y << ", " << state_.p_z << "]\n"
+        << "  q: [" << state_.q_x << ", " << state_.q_y << ", " << state_.q_z << ", " << state_.q_w << "]\n"
+        << "  b_a: [" << state_.b_a_x << ", " << state_.b_a_y << ", " << state_.b_a_z << "]\n"
+        << "  b_w: [" << state_.b_w_x << ", " << state_.b_w_y << ", " << state_.b_w_z << "]\n";
+  }
 
-      resource_csv.addRow(profiler::now(), cpu_usage, cpu_usage_usr, cpu_usage_sys, mem_usage_in_bytes, mem_usage_debug);
+  /**
+   * One-line metrics.json with the sweep-scoring scalars: ATE against ground truth (rigid Umeyama alignment, see
+   * trajectory_metrics.h), overall realtime factor and peak RSS. Sweep scoring reads this single line instead of
+   * re-reading and re-aligning the full CSV outputs in Python.
+   */
+  void writeMetrics() {
+    auto result = metrics_->compute();
+    double t_sim_passed = t_sim_last_ - t_0_;
+    double rt_factor = t_sim_passed > 0 ? calculation_time_ * 1e-6 / t_sim_passed : 0.0;
+
+    std::ofstream out(output_path_ / "metrics.json");
+    out << std::setprecision(17) << "{";
+    if (result.valid)
+      out << "\"ate_mean\": " << result.ate_mean
+          << ", \"ate_max\": " << result.ate_max
+          << ", \"ate_rmse\": " << result.ate_rmse;
+    else
+      out << "\"ate_mean\": null, \"ate_max\": null, \"ate_rmse\": null";
+    out << ", \"num_matched\": " << result.num_matched
+        << ", \"num_estimates\": " << result.num_estimates
+        << ", \"num_gt\": " << result.num_gt
+        << ", \"rt_factor\": " << rt_factor
+        << ", \"calculation_time_us\": " << calculation_time_
+        << ", \"peak_rss_bytes\": " << x_evaluate::ResourceSampler::peakRssBytes()
+        << "}\n";
+  }
 
-      rusage_walltime = rusage_walltime_new;
-      prev_rusage = cur_rusage;
+  /// Dumps the per-modality processing-time percentiles maintained online by the histograms, so tail-latency
+  /// questions are answered right after the run instead of by re-aggregating millions of realtime.csv rows.
+  void writeLatencySummary() {
+    x::CsvWriter<std::string, uint64_t, uint64_t, double,
+                 uint64_t, uint64_t, uint64_t, uint64_t, uint64_t> summary(
+      (output_path_ / "latency_summary.csv").string(),
+      {"process_type", "count", "min_us", "mean_us", "p50_us", "p90_us", "p99_us", "p999_us", "max_us"});
+    for (auto kind : {MsgKind::IMU, MsgKind::IMAGE, MsgKind::EVENTS}) {
+      const auto &hist = latency_hist_[static_cast<size_t>(kind)];
+      if (hist.count() == 0)
+        continue;
+      summary.addRow(msgKindName(kind), hist.count(), hist.min(), hist.mean(),
+                     hist.quantile(0.5), hist.quantile(0.9), hist.quantile(0.99), hist.quantile(0.999), hist.max());
     }
+  }
 
-    if (!filer_initialized && vio.isInitialized()) {
-      filer_initialized = true;
-//        auto count = show_progress.count();
-//        show_progress.restart(view.size());
-//        show_progress += count;
-    }
+  /// Writes the blocks captured since the last dump to the next profiling.NNN.prof segment and re-arms the capture
+  /// (dumpBlocksToFile stops profiling and clears the stored blocks).
+  void dumpProfilingSegment() {
+    char segment_name[32];
+    std::snprintf(segment_name, sizeof segment_name, "profiling.%03u.prof", profiling_segment_idx_++);
+    profiler::dumpBlocksToFile((output_path_ / segment_name).c_str());
+    EASY_PROFILER_ENABLE;
+  }
 
-    if (!process_type.empty() && filer_initialized) {
-      auto duration_in_us = profiler::toMicroseconds(stop - start);
-      calculation_time += duration_in_us;
+  /**
+   * Persists the harness-side progress so a preempted run can continue with --resume_from instead of starting over.
+   * Outputs are flushed first, so on resume the appended rows line up with the checkpointed cursor.
+   */
+  void writeCheckpoint(double t_sim) {
+    pose_csv_->flush();
+    imu_bias_csv_->flush();
+    rt_csv_->flush();
+    // resource sinks are deliberately not flushed here: the sampler thread is writing them concurrently, and on
+    // resume an unflushed tail only costs a few monitoring rows
+    if (gt_csv_) {
+      flushGtRows();  // the staged block belongs before the checkpointed counter_pose_ cursor
+      gt_csv_->flush();
+    }
+    x::DebugMemoryMonitor::instance().flush_all();
+
+    fs::path tmp = output_path_ / "checkpoint.yaml.tmp";
+    {
+      std::ofstream out(tmp);
+      out << std::setprecision(17)
+          << "t_sim: " << t_sim << "\n"
+          << "calculation_time_us: " << calculation_time_ << "\n"
+          << "counter_imu: " << counter_imu_ << "\n"
+          << "counter_image: " << counter_image_ << "\n"
+          << "counter_events: " << counter_events_ << "\n"
+          << "counter_pose: " << counter_pose_ << "\n";
+    }
+    fs::rename(tmp, output_path_ / "checkpoint.yaml");  // atomic --> never observe a torn checkpoint
+  }
 
-      addPose(pose_csv, process_type, state);
-      addImuBias(imu_bias_csv, process_type, state);
-      rt_csv.addRow(m.getTime().toSec(), calculation_time * 1e-6, profiler::now(), process_type, duration_in_us);
+  /**
+   * Early-abort guard for parameter sweeps: once per --min_progress_check_s of simulated time, the realtime factor
+   * over that window is compared against --max_rt_factor. Diverged parameter sets running at e.g. 10x
+   * slower-than-realtime get cut off after one window instead of burning hours.
+   */
+  void checkRtFactor(double t_bag) {
+    if (rt_window_t_sim_ == std::numeric_limits<double>::infinity()) {
+      rt_window_t_sim_ = t_bag;
+      rt_window_calc_time_ = calculation_time_;
+      return;
     }
 
-    ++show_progress;
+    double window_sim = t_bag - rt_window_t_sim_;
+    if (window_sim < job_.min_progress_check_s)
+      return;
+
+    double window_rt_factor = (calculation_time_ - rt_window_calc_time_) * 1e-6 / window_sim;
+    if (window_rt_factor > job_.max_rt_factor) {
+      aborted_ = true;
+      std::cerr << std::endl << "ABORTING: realtime factor " << window_rt_factor << " exceeded limit "
+                << job_.max_rt_factor << " over the last " << window_sim << "s of simulated time" << std::endl;
+
+      std::ofstream marker(output_path_ / "aborted.txt");
+      marker << "max_rt_factor_exceeded" << std::endl
+             << "t_sim: " << std::setprecision(17) << t_bag << std::endl
+             << "window_rt_factor: " << window_rt_factor << std::endl
+             << "max_rt_factor: " << job_.max_rt_factor << std::endl;
+    }
+    rt_window_t_sim_ = t_bag;
+    rt_window_calc_time_ = calculation_time_;
   }
 
-  profiler::dumpBlocksToFile((output_path / "profiling.prof").c_str());
-//    JsonExporter je;
-//    je.convert((output_path / "profiling.prof").c_str(), (output_path / "profiling.json").c_str());
+  void finishMessage(MsgKind kind, double t_bag, profiler::timestamp_t start_ts, profiler::timestamp_t stop_ts) {
+    if (t_bag < t_0_)
+      t_0_ = t_bag;
+    t_sim_last_ = t_bag;
 
-  std::cerr << "Processed " << counter_imu << " IMU, "
-            << counter_image << " image, "
-            << counter_events << " event and "
-            << counter_pose << " pose messages" << std::endl;
+    if (t_bag < t_last_flush_)  // initialization
+      t_last_flush_ = t_bag;
 
-  std::cerr << "Writing outputs to folder " << output_path << std::endl;
+    if (t_bag - t_last_flush_ > 5.0) {
+      t_last_flush_ = t_bag;
+      requestDebugFlush();  // runs on the flush worker --> no stall in the process_time samples at the 5s marks
+    }
 
-  // manually flush to ensure files are dumped even in case of memory corruption (double-free in destructors etc.)
-  x::DebugMemoryMonitor::instance().flush_all();
+    if (job_.checkpoint_interval_s > 0) {
+      if (t_bag < t_last_checkpoint_)  // initialization
+        t_last_checkpoint_ = t_bag;
+      if (t_bag - t_last_checkpoint_ > job_.checkpoint_interval_s) {
+        t_last_checkpoint_ = t_bag;
+        writeCheckpoint(t_bag);
+      }
+    }
 
-  bag.close();
+    // rotating profiler capture: dump the finished window to its own segment file and keep recording --> full-run
+    // visibility with bounded file sizes and bounded in-memory block storage (replaces the old
+    // "profile 1s only, then EASY_PROFILER_DISABLE" hack)
+    if (job_.enable_profiling && job_.profiling_segment_s > 0) {
+      if (t_bag < t_last_profile_dump_)  // initialization
+        t_last_profile_dump_ = t_bag;
+      if (t_bag - t_last_profile_dump_ > job_.profiling_segment_s) {
+        t_last_profile_dump_ = t_bag;
+        dumpProfilingSegment();
+      }
+    }
 
-  std::cerr << "Evaluation completed " << get_time_string_in_utc();
-  std::cerr << "Good bye!" << std::endl;
-  return 0;
+    if (!filter_initialized_ && vio_.isInitialized())
+      filter_initialized_ = true;
+
+    if (kind != MsgKind::IGNORE && filter_initialized_) {
+      auto duration_in_us = profiler::toMicroseconds(stop_ts - start_ts);
+      calculation_time_ += duration_in_us;
+
+      latency_hist_[static_cast<size_t>(kind)].record(duration_in_us);
+
+      if (metrics_)  // undecimated: the metrics engine sees every update, no matter what reaches pose.csv
+        metrics_->addEstimate(state_.t, state_.p_x, state_.p_y, state_.p_z);
+
+      const std::string &process_type = msgKindName(kind);
+      // IMU rows are pure propagation between updates --> they decimate cleanly; image/event updates always log
+      bool log_pose_row = kind != MsgKind::IMU || job_.pose_log_decimation <= 1 ||
+                          (imu_log_counter_++ % job_.pose_log_decimation) == 0;
+      if (log_pose_row) {
+        addPose(*pose_csv_, process_type, state_);
+        addImuBias(*imu_bias_csv_, process_type, state_);
+      }
+      rt_csv_->addRow(t_bag, calculation_time_ * 1e-6, profiler::now(), process_type, duration_in_us);
+
+      if (job_.max_rt_factor > 0)
+        checkRtFactor(t_bag);
+    }
+
+    if (show_progress_)
+      show_progress_->tick(t_bag, calculation_time_);
+  }
+
+  Vio &vio_;
+  fs::path output_path_;
+  const x::Params &params_;
+  const EvalJob &job_;
+
+  std::unique_ptr<PoseSink> pose_csv_;
+  std::unique_ptr<ImuBiasSink> imu_bias_csv_;
+  std::unique_ptr<RtSink> rt_csv_;
+  std::unique_ptr<ResourceSink> resource_csv_;
+  std::unique_ptr<ThreadResourceSink> resource_threads_csv_;
+  std::unique_ptr<x_evaluate::ResourceSampler> resource_sampler_;
+  std::unique_ptr<x_evaluate::FrameDumpSink> frame_dump_;
+  std::unique_ptr<x_evaluate::PerfCounters> perf_counters_;
+  x_evaluate::PerfCounters::Sample perf_totals_[3] {};  // indexed by MsgKind IMU / IMAGE / EVENTS
+  std::unique_ptr<x_evaluate::TrajectoryMetrics> metrics_;
+  std::unique_ptr<GTSink> gt_csv_;
+  static constexpr size_t kGtBatchRows = 256;
+  std::vector<GTSink::Row> gt_batch_;  // preallocated staging buffer, written in blocks
+
+  uint64_t counter_imu_ = 0, counter_image_ = 0, counter_events_ = 0, counter_pose_ = 0;
+  uint64_t imu_log_counter_ = 0;  // decimation phase of the IMU-triggered pose/bias rows
+  bool filter_initialized_ = false;
+
+  StateSnapshot state_;  // only the logged scalars, not the full filter state
+  x_evaluate::LatencyHistogram latency_hist_[3];  // indexed by MsgKind IMU / IMAGE / EVENTS
+  x_evaluate::EventArrayPool event_pool_;
+  x_evaluate::EventBatchSoA event_batch_;  // scratch for the batched conversion kernel
+  std::vector<x::Event> pending_events_;   // accumulation buffer of the re-chunking stage
+  uint32_t pending_height_ = 0, pending_width_ = 0;
+  unsigned int rechunk_seq_ = 0;
+  double last_events_t_bag_ = 0.0;
+  double t_0_ = std::numeric_limits<double>::infinity();
+  double t_sim_last_ = 0.0;
+  double t_last_flush_ = std::numeric_limits<double>::infinity();
+  std::unique_ptr<ProgressReporter> show_progress_;
+
+  profiler::timestamp_t calculation_time_ = 0;
+
+  bool aborted_ = false;
+  double replay_t_begin_ = 0.0;  // virtual-clock origin of --replay_factor pacing
+  std::chrono::steady_clock::time_point replay_wall_start_;
+  double resume_t_ = 0.0;
+  double t_last_checkpoint_ = std::numeric_limits<double>::infinity();
+  double t_last_profile_dump_ = std::numeric_limits<double>::infinity();
+  uint32_t profiling_segment_idx_ = 0;
+
+  std::thread debug_flush_worker_;
+  std::mutex debug_flush_mutex_;
+  std::condition_variable debug_flush_cv_;
+  bool debug_flush_requested_ = false, debug_flush_done_ = false;
+  double rt_window_t_sim_ = std::numeric_limits<double>::infinity();
+  profiler::timestamp_t rt_window_calc_time_ = 0;
+};
+
+
+template <class Vio>
+int evaluate(Vio &vio, const fs::path &output_path, const x::Params& params, const EvalJob& job) {
+  EvaluationRun<Vio> run(vio, output_path, params, job);
+  int ret = job.input_cache.empty() ? run.replayBag() : run.replayCache();
+  run.finish();
+  return ret;
 }
 
 
-int main(int argc, char **argv) {
+/**
+ * One-time conversion of a rosbag into the flat pre-decoded cache format, so that repeated runs on the same sequence
+ * (parameter sweeps) replay via mmap instead of re-deserializing the bag.
+ */
+int convertBagToCache(const EvalJob &job, const std::string &cache_file) {
+  std::cerr << "Converting rosbag '" << job.input_bag << "' to cache '" << cache_file << "'" << std::endl;
 
-  std::cerr << "Running " << argv[0] << " " << get_time_string_in_utc() << std::endl;
+  rosbag::Bag bag;
+  bag.open(job.input_bag);
+  rosbag::View view(bag);
 
-  google::ParseCommandLineFlags(&argc, &argv, true);
+  x_evaluate::BagCacheWriter writer(cache_file);
+  boost::progress_display show_progress(view.size(), std::cerr);
 
-  if (FLAGS_output_folder.empty()) {
-    std::cerr << "ERROR: No output folder specified, provide --output_folder" << std::endl;
-    return 1;
+  for (rosbag::MessageInstance const &m : view) {
+    const double t_bag = m.getTime().toSec();
+
+    if (m.getTopic() == job.imu_topic) {
+      auto msg = m.instantiate<sensor_msgs::Imu>();
+      x_evaluate::CachedImu imu {};
+      imu.t = msg->header.stamp.toSec();
+      imu.seq = msg->header.seq;
+      imu.w[0] = msg->angular_velocity.x; imu.w[1] = msg->angular_velocity.y; imu.w[2] = msg->angular_velocity.z;
+      imu.a[0] = msg->linear_acceleration.x; imu.a[1] = msg->linear_acceleration.y; imu.a[2] = msg->linear_acceleration.z;
+      writer.writeRecord(MsgKind::IMU, t_bag, &imu, sizeof imu);
+
+    } else if (m.getTopic() == job.image_topic) {
+      auto msg = m.instantiate<sensor_msgs::Image>();
+      x_evaluate::CachedImageHeader hdr {};
+      hdr.t = msg->header.stamp.toSec();
+      hdr.seq = msg->header.seq;
+      hdr.height = msg->height;
+      hdr.width = msg->width;
+      hdr.step = msg->step;
+      std::strncpy(hdr.encoding, msg->encoding.c_str(), sizeof hdr.encoding - 1);
+      hdr.data_size = msg->data.size();
+      writer.writeRecord(MsgKind::IMAGE, t_bag, &hdr, sizeof hdr, msg->data.data(), msg->data.size());
+
+    } else if (!job.events_topic.empty() && m.getTopic() == job.events_topic) {
+      auto msg = m.instantiate<dvs_msgs::EventArray>();
+      x_evaluate::CachedEventsHeader hdr {};
+      hdr.t = msg->header.stamp.toSec();
+      hdr.seq = msg->header.seq;
+      hdr.height = msg->height;
+      hdr.width = msg->width;
+      hdr.num_events = msg->events.size();
+      std::vector<x_evaluate::CachedEvent> events;
+      events.reserve(msg->events.size());
+      for (const auto &e : msg->events)
+        events.push_back({e.x, e.y, e.ts.toSec(), e.polarity});
+      writer.writeRecord(MsgKind::EVENTS, t_bag, &hdr, sizeof hdr,
+                         events.data(), events.size() * sizeof(x_evaluate::CachedEvent));
+
+    } else if (!job.pose_topic.empty() && m.getTopic() == job.pose_topic) {
+      if (m.isType<geometry_msgs::PoseStamped>()) {
+        auto p = m.instantiate<geometry_msgs::PoseStamped>();
+        x_evaluate::CachedPose pose {p->header.stamp.toSec(),
+                                     {p->pose.position.x, p->pose.position.y, p->pose.position.z},
+                                     {p->pose.orientation.x, p->pose.orientation.y, p->pose.orientation.z, p->pose.orientation.w}};
+        writer.writeRecord(MsgKind::GT_POSE, t_bag, &pose, sizeof pose);
+      } else if (m.isType<geometry_msgs::PoseWithCovarianceStamped>()) {
+        auto p = m.instantiate<geometry_msgs::PoseWithCovarianceStamped>();
+        x_evaluate::CachedPose pose {p->header.stamp.toSec(),
+                                     {p->pose.pose.position.x, p->pose.pose.position.y, p->pose.pose.position.z},
+                                     {p->pose.pose.orientation.x, p->pose.pose.orientation.y,
+                                      p->pose.pose.orientation.z, p->pose.pose.orientation.w}};
+        writer.writeRecord(MsgKind::GT_POSE, t_bag, &pose, sizeof pose);
+      } else if (m.isType<tf2_msgs::TFMessage>()) {
+        auto tf = m.instantiate<tf2_msgs::TFMessage>();
+        for (const auto &p : tf->transforms) {
+          if (!job.gt_child_frame.empty() && p.child_frame_id != job.gt_child_frame)
+            continue;
+          x_evaluate::CachedPose pose {p.header.stamp.toSec(),
+                                       {p.transform.translation.x, p.transform.translation.y, p.transform.translation.z},
+                                       {p.transform.rotation.x, p.transform.rotation.y, p.transform.rotation.z, p.transform.rotation.w}};
+          writer.writeRecord(MsgKind::GT_POSE, t_bag, &pose, sizeof pose);
+        }
+      }
+    }
+    ++show_progress;
   }
 
-  // directly reads yaml file, without the need for a ROS master / ROS parameter server
-  YAML::Node config = YAML::LoadFile(FLAGS_params_file);
+  writer.close();
+  bag.close();
+  std::cerr << "Cache written " << get_time_string_in_utc();
+  return 0;
+}
+
+
+bool loadParams(const std::string& params_file, x::Params& params) {
+  // binary fast path: an unchanged params file (hash-keyed, see params_cache.h) skips the YAML parse entirely --
+  // startup cost matters when sweeps launch thousands of short runs
+  x_evaluate::ParamsCache cache(params_file);
   x::ParameterLoader l;
-  x::Params params;
-  auto success = l.loadXParams(params, [config](const std::string& key, auto &par) -> bool {
+
+  if (cache.valid()) {
+    auto success = l.loadXParams(params, [&cache](const std::string& key, auto &par) -> bool {
+      return cache.lookup(key, par);
+    });
+    std::cerr << "Reading cached config '" << cache.cacheFile() << "' was "
+              << (success ? "successful" : "failing") << std::endl;
+    if (success)
+      return true;
+    // e.g. parameter types changed between library versions --> fall through to the YAML path, which rewrites it
+  }
+
+  // directly reads yaml file, without the need for a ROS master / ROS parameter server
+  YAML::Node config = YAML::LoadFile(params_file);
+  auto success = l.loadXParams(params, [config, &cache](const std::string& key, auto &par) -> bool {
     if (config[key].IsDefined()) {
       // this is ugly but the only way to get the correct auto type for the template interface as<T>
       const auto& v = config[key].as<std::remove_reference_t<decltype(par)>>();
       par = v;
+      cache.record(key, par);
       return true;
     }
     return false;
   });
 
-  std::cerr << "Reading config '" << FLAGS_params_file << "' was " << (success ? "successful" : "failing")
+  if (success)
+    cache.write();
+
+  std::cerr << "Reading config '" << params_file << "' was " << (success ? "successful" : "failing")
             << std::endl;
+  return success;
+}
 
-  if (!success)
-    return 1;
 
-  fs::path output_path(FLAGS_output_folder);
-  fs::create_directories(output_path);
-  fs::copy(FLAGS_params_file, output_path / "params.yaml", fs::copy_options::overwrite_existing);
+std::unique_ptr<x::AbstractVio> makeVio(const EvalJob& job, const fs::path& output_path) {
+  // with --compressed_frame_dump the harness dumps frames itself --> keep the logger's raw per-frame files off
+  x::XVioPerformanceLoggerPtr xvio_logger = std::make_shared<x::XVioPerformanceLogger>(
+    output_path, job.dump_input_frames && !job.compressed_frame_dump,
+    job.dump_debug_frames && !job.compressed_frame_dump);
+
+  switch(frontends[job.frontend]) {
+    case Frontend::XVIO:
+      return std::make_unique<x::VIO>(xvio_logger);
+    case Frontend::EKLT: {
+      x::EkltPerformanceLoggerPtr eklt_logger = std::make_shared<x::EkltPerformanceLogger>(output_path);
+      x::EventsPerformanceLoggerPtr events_logger = std::make_shared<x::EventsPerformanceLogger>(output_path);
+      return std::make_unique<x::EKLTVIO>(xvio_logger, events_logger, eklt_logger);
+    }
+    case Frontend::HASTE: {
+      x::EventsPerformanceLoggerPtr events_logger = std::make_shared<x::EventsPerformanceLogger>(output_path);
+      return std::make_unique<x::HASTEVIO>(xvio_logger, events_logger);
+    }
+    case Frontend::EVIO:
+      return std::make_unique<x::EVIO>(xvio_logger);
+    default:
+      return nullptr;
+  }
+}
 
-  x::XVioPerformanceLoggerPtr xvio_logger =
-    std::make_shared<x::XVioPerformanceLogger>(output_path, FLAGS_dump_input_frames, FLAGS_dump_debug_frames);
 
+/**
+ * Same frontend wiring as makeVio(), but the VIO is handed to f as its concrete type: the evaluation loop then
+ * instantiates per frontend class and the hot processImu()/processEventsMeasurement() call sites are devirtualized.
+ */
+template <class F>
+int withConcreteVio(const EvalJob& job, const fs::path& output_path, F&& f) {
+  // with --compressed_frame_dump the harness dumps frames itself --> keep the logger's raw per-frame files off
+  x::XVioPerformanceLoggerPtr xvio_logger = std::make_shared<x::XVioPerformanceLogger>(
+    output_path, job.dump_input_frames && !job.compressed_frame_dump,
+    job.dump_debug_frames && !job.compressed_frame_dump);
 
-  switch(frontends[FLAGS_frontend]) {
+  switch(frontends[job.frontend]) {
     case Frontend::XVIO: {
       x::VIO vio(xvio_logger);
-      return evaluate(vio, output_path, params);
+      return f(vio);
     }
     case Frontend::EKLT: {
       x::EkltPerformanceLoggerPtr eklt_logger = std::make_shared<x::EkltPerformanceLogger>(output_path);
       x::EventsPerformanceLoggerPtr events_logger = std::make_shared<x::EventsPerformanceLogger>(output_path);
       x::EKLTVIO vio(xvio_logger, events_logger, eklt_logger);
-      return evaluate(vio, output_path, params);
+      return f(vio);
     }
     case Frontend::HASTE: {
       x::EventsPerformanceLoggerPtr events_logger = std::make_shared<x::EventsPerformanceLogger>(output_path);
       x::HASTEVIO vio(xvio_logger, events_logger);
-      return evaluate(vio, output_path, params);
+      return f(vio);
     }
     case Frontend::EVIO: {
       x::EVIO vio(xvio_logger);
-      return evaluate(vio, output_path, params);
+      return f(vio);
     }
-
     default:
       std::cerr << "Invalid frontend type, unable to evaluate" << std::endl;
       return 1;
   }
 }
+
+
+/**
+ * Single-pass comparison mode (--frontend XVIO,EKLT,...): the bag is read and decoded exactly once and every decoded
+ * message is fanned out to one evaluation per frontend, each running on its own thread with its own output subfolder.
+ * Decode and I/O dominate comparison runtime, so this replaces N full bag passes by one.
+ */
+int runComparison(const EvalJob& base_job, const std::vector<std::string>& frontend_names) {
+  x::Params params;
+  if (!loadParams(base_job.params_file, params))
+    return 1;
+
+  struct FrontendSlot {
+    EvalJob job;
+    std::unique_ptr<x::AbstractVio> vio;
+    std::unique_ptr<EvaluationRun<x::AbstractVio>> run;
+    std::unique_ptr<x_evaluate::BoundedQueue<PrefetchedMessage>> queue;
+    std::thread worker;
+  };
+
+  std::vector<std::unique_ptr<FrontendSlot>> slots;
+  bool any_events = false;
+  for (const auto& name : frontend_names) {
+    auto slot = std::make_unique<FrontendSlot>();
+    slot->job = base_job;
+    slot->job.frontend = name;
+    slot->job.output_folder = (fs::path(base_job.output_folder) / name).string();
+    slot->job.enable_profiling = false;  // easy_profiler state is process-global
+    slot->job.show_progress = false;
+    slot->job.deep_copy_images = true;  // slots run concurrently off one decoded mat, see handleImage()
+
+    fs::path output_path(slot->job.output_folder);
+    fs::create_directories(output_path);
+    fs::copy(slot->job.params_file, output_path / "params.yaml", fs::copy_options::overwrite_existing);
+
+    slot->vio = makeVio(slot->job, output_path);
+    slot->run = std::make_unique<EvaluationRun<x::AbstractVio>>(*slot->vio, output_path, params, slot->job);
+    any_events |= slot->vio->doesProcessEvents();
+
+    size_t window = slot->job.prefetch_window > 0 ? slot->job.prefetch_window : 1024;
+    slot->queue = std::make_unique<x_evaluate::BoundedQueue<PrefetchedMessage>>(window);
+    slots.push_back(std::move(slot));
+  }
+
+  std::cerr << "Reading rosbag '" << base_job.input_bag << "' once for " << slots.size() << " frontends" << std::endl;
+  rosbag::Bag bag;
+  bag.open(base_job.input_bag);
+
+  auto from = ros::TIME_MIN;
+  auto to = ros::TIME_MAX;
+  if (base_job.from > std::numeric_limits<double>::min())
+    from = ros::Time(base_job.from);
+  if (base_job.to < std::numeric_limits<double>::max())
+    to = ros::Time(base_job.to);
+  rosbag::View view(bag, from, to);
+
+  for (auto& slot : slots) {
+    slot->run->start(view.getBeginTime().toSec(), view.size());
+    slot->worker = std::thread([s = slot.get()] {
+      PrefetchedMessage msg;
+      while (s->queue->pop(msg))
+        s->run->dispatchMessage(msg);
+    });
+  }
+
+  MessageDecoder decoder(base_job, any_events, &params);  // all slots share one params file --> decode images once
+  try {
+    for (rosbag::MessageInstance const &m : view) {
+      PrefetchedMessage msg = decoder.decodeMessage(m);
+      for (auto& slot : slots)
+        slot->queue->push(PrefetchedMessage(msg));  // shared_ptr copies, decoded payload is shared
+    }
+  } catch (...) {
+    // stop the slot workers before unwinding destroys their joinable threads -- the error then fails this job
+    // through the normal per-job handling instead of terminating the process
+    for (auto& slot : slots)
+      slot->queue->cancel();
+    for (auto& slot : slots)
+      slot->worker.join();
+    throw;
+  }
+
+  for (auto& slot : slots)
+    slot->queue->close();
+  for (auto& slot : slots)
+    slot->worker.join();
+
+  bag.close();
+
+  for (auto& slot : slots)
+    slot->run->finish();
+  return 0;
+}
+
+
+/**
+ * Resident parameter-sweep server: the input is read and decoded into memory exactly once, then one evaluation per
+ * params .yaml in --sweep_params_dir runs against the in-memory streams. Startup and decode drop out of the per-run
+ * cost entirely, which is what dominates short exploration runs.
+ */
+int runSweep(const EvalJob& base_job, const std::string& params_dir) {
+  std::vector<fs::path> param_files;
+  for (const auto& entry : fs::directory_iterator(params_dir)) {
+    if (entry.path().extension() == ".yaml")
+      param_files.push_back(entry.path());
+  }
+  std::sort(param_files.begin(), param_files.end());
+
+  if (param_files.empty()) {
+    std::cerr << "ERROR: no .yaml parameter files found in '" << params_dir << "'" << std::endl;
+    return 1;
+  }
+
+  std::vector<PrefetchedMessage> messages;
+  double t_begin = 0.0;
+
+  if (base_job.input_cache.empty()) {
+    std::cerr << "Reading rosbag '" << base_job.input_bag << "' once for " << param_files.size()
+              << " parameter sets" << std::endl;
+    rosbag::Bag bag;
+    bag.open(base_job.input_bag);
+
+    auto from = ros::TIME_MIN;
+    auto to = ros::TIME_MAX;
+    if (base_job.from > std::numeric_limits<double>::min())
+      from = ros::Time(base_job.from);
+    if (base_job.to < std::numeric_limits<double>::max())
+      to = ros::Time(base_job.to);
+    rosbag::View view(bag, from, to);
+    t_begin = view.getBeginTime().toSec();
+
+    // decode events whenever a topic is configured; frontends that do not process events skip them on dispatch.
+    // images stay raw here: x::TiledImage layout depends on the tiling parameters, which vary across the sweep
+    MessageDecoder decoder(base_job, true);
+    messages.reserve(view.size());
+    for (rosbag::MessageInstance const &m : view)
+      messages.push_back(decoder.decodeMessage(m));
+    bag.close();
+  }
+
+  int num_failed = 0;
+  for (const auto& params_file : param_files) {
+    EvalJob job = base_job;
+    job.params_file = params_file.string();
+    job.output_folder = (fs::path(base_job.output_folder) / params_file.stem()).string();
+    job.enable_profiling = false;
+    // resident messages are replayed for every parameter set, and decode aliases msg->data for MONO8 bags --
+    // in-place drawing by one run must not leak into the input pixels of the next (see handleImage())
+    job.deep_copy_images = job.input_cache.empty();
+
+    std::cerr << std::endl << "=== Evaluating parameter set '" << params_file.stem().string() << "' ===" << std::endl;
+
+    x::Params params;
+    if (!loadParams(job.params_file, params)) {
+      ++num_failed;
+      continue;
+    }
+
+    fs::path output_path(job.output_folder);
+    fs::create_directories(output_path);
+    fs::copy(job.params_file, output_path / "params.yaml", fs::copy_options::overwrite_existing);
+
+    auto vio = makeVio(job, output_path);
+    EvaluationRun<x::AbstractVio> run(*vio, output_path, params, job);
+    if (job.input_cache.empty())
+      run.replayMessages(messages, t_begin);
+    else
+      run.replayCache();  // mmap replay is already resident after the first run via the page cache
+    run.finish();
+  }
+
+  std::cerr << (param_files.size() - num_failed) << "/" << param_files.size()
+            << " parameter sets evaluated successfully" << std::endl;
+  return num_failed == 0 ? 0 : 1;
+}
+
+
+int runJob(const EvalJob& job) {
+  if (job.frontend.find(',') != std::string::npos) {
+    std::vector<std::string> names;
+    size_t pos = 0;
+    while (pos <= job.frontend.size()) {
+      auto comma = job.frontend.find(',', pos);
+      if (comma == std::string::npos)
+        comma = job.frontend.size();
+      names.push_back(job.frontend.substr(pos, comma - pos));
+      pos = comma + 1;
+    }
+    return runComparison(job, names);
+  }
+
+  x::Params params;
+  if (!loadParams(job.params_file, params))
+    return 1;
+
+  fs::path output_path(job.output_folder);
+  fs::create_directories(output_path);
+  fs::copy(job.params_file, output_path / "params.yaml", fs::copy_options::overwrite_existing);
+
+  return withConcreteVio(job, output_path, [&](auto& vio) {
+    return evaluate(vio, output_path, params, job);
+  });
+}
+
+
+int main(int argc, char **argv) {
+
+  std::cerr << "Running " << argv[0] << " " << get_time_string_in_utc() << std::endl;
+
+  google::ParseCommandLineFlags(&argc, &argv, true);
+
+  if (!FLAGS_write_cache.empty())
+    return convertBagToCache(jobFromFlags(), FLAGS_write_cache);
+
+  if (!FLAGS_sweep_params_dir.empty()) {
+    if (FLAGS_output_folder.empty()) {
+      std::cerr << "ERROR: No output folder specified, provide --output_folder" << std::endl;
+      return 1;
+    }
+    return runSweep(jobFromFlags(), FLAGS_sweep_params_dir);
+  }
+
+  if (!FLAGS_jobs_file.empty()) {
+    auto jobs = jobsFromManifest(FLAGS_jobs_file);
+
+    if (FLAGS_coordinator_port > 0) {
+      // distributed mode: hand out manifest indices to remote workers, all outputs land on shared storage in the
+      // same per-job layout as the local scheduler
+      x_evaluate::DistributedCoordinator coordinator(static_cast<uint16_t>(FLAGS_coordinator_port), jobs.size());
+      size_t num_failed = coordinator.run();
+      std::cerr << (jobs.size() - num_failed) << "/" << jobs.size() << " jobs completed successfully" << std::endl;
+      return num_failed == 0 ? 0 : 1;
+    }
+
+    if (!FLAGS_coordinator.empty()) {
+      auto colon = FLAGS_coordinator.rfind(':');
+      if (colon == std::string::npos) {
+        std::cerr << "ERROR: --coordinator expects host:port" << std::endl;
+        return 1;
+      }
+      std::string host = FLAGS_coordinator.substr(0, colon);
+      auto port = static_cast<uint16_t>(std::stoul(FLAGS_coordinator.substr(colon + 1)));
+      size_t num_slots = FLAGS_num_workers > 0 ? FLAGS_num_workers : std::thread::hardware_concurrency();
+      num_slots = std::min(num_slots, jobs.size());
+      return x_evaluate::runDistributedWorker(host, port, num_slots, [&jobs](size_t idx) -> int {
+        if (idx >= jobs.size()) {
+          std::cerr << "ERROR: coordinator sent job index " << idx << ", manifest has " << jobs.size()
+                    << " entries -- manifests out of sync?" << std::endl;
+          return 1;
+        }
+        try {
+          return runJob(jobs[idx]);
+        } catch (const std::exception& e) {
+          std::cerr << "ERROR: job '" << jobs[idx].output_folder << "' failed: " << e.what() << std::endl;
+          return 1;
+        }
+      });
+    }
+
+    size_t num_workers = FLAGS_num_workers > 0 ? FLAGS_num_workers : std::thread::hardware_concurrency();
+    num_workers = std::min(num_workers, jobs.size());
+    std::cerr << "Running " << jobs.size() << " jobs from '" << FLAGS_jobs_file << "' on "
+              << num_workers << " workers" << std::endl;
+
+    x_evaluate::JobScheduler scheduler(num_workers);
+    std::atomic<int> num_failed {0};
+    for (const auto& job : jobs) {
+      scheduler.addJob([job, &num_failed] {
+        try {
+          if (runJob(job) != 0)
+            ++num_failed;
+        } catch (const std::exception& e) {
+          std::cerr << "ERROR: job '" << job.output_folder << "' failed: " << e.what() << std::endl;
+          ++num_failed;
+        }
+      });
+    }
+    scheduler.runToCompletion();
+
+    std::cerr << (jobs.size() - num_failed) << "/" << jobs.size() << " jobs completed successfully" << std::endl;
+    return num_failed == 0 ? 0 : 1;
+  }
+
+  if (FLAGS_output_folder.empty()) {
+    std::cerr << "ERROR: No output folder specified, provide --output_folder" << std::endl;
+    return 1;
+  }
+
+  return runJob(jobFromFlags());
+}
@@ -0,0 +1,143 @@
+//
+// Created by Florian Mahlknecht on 2022-06-27.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Compressed streaming dump of input / debug frames. The raw per-frame image files written by XVioPerformanceLogger
+// dominate run time and disk usage on long sequences (hundreds of GB), so frame dumping is usually left off. This
+// sink hands frames to a background thread that zstd-compresses them into one indexed container file; see
+// scripts/extract_frame_dump.py for turning the container back into the frames/ + dumped_frames.csv layout that
+// scripts/visualize_frame_output.py reads. Falls back to uncompressed storage when zstd headers are unavailable.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define X_EVALUATE_HAVE_ZSTD 1
+#endif
+
+#include "prefetch.h"
+
+namespace x_evaluate {
+
+constexpr char kFrameDumpMagic[8] = {'X', 'E', 'V', 'F', 'D', 'U', 'M', 'P'};
+constexpr char kFrameIndexMagic[8] = {'X', 'E', 'V', 'F', 'D', 'I', 'D', 'X'};
+constexpr uint32_t kFrameDumpVersion = 1;
+
+/**
+ * Writes frames to an indexed container file from a dedicated worker thread. addFrame() takes a shallow cv::Mat copy
+ * and returns immediately; the bounded hand-off queue keeps memory use flat if compression falls behind. File layout:
+ *   magic[8] | u32 version | u8 codec (0 = raw, 1 = zstd)
+ *   records: u32 type_len, type | f64 t | u32 rows | u32 cols | i32 cv_type | u64 raw_size | u64 stored_size | bytes
+ *   index:   u64 num_frames | u64 offsets[num_frames] | u64 index_offset | magic[8]
+ */
+class FrameDumpSink {
+ public:
+  explicit FrameDumpSink(const std::string &filename)
+    : out_(filename, std::ios::binary | std::ios::trunc), queue_(kQueueCapacity) {
+    if (!out_)
+      throw std::runtime_error("unable to open frame dump file '" + filename + "' for writing");
+    out_.write(kFrameDumpMagic, sizeof kFrameDumpMagic);
+    writeRaw<uint32_t>(kFrameDumpVersion);
+#ifdef X_EVALUATE_HAVE_ZSTD
+    writeRaw<uint8_t>(1);
+#else
+    writeRaw<uint8_t>(0);
+#endif
+    worker_ = std::thread([this] { workerLoop(); });
+  }
+
+  ~FrameDumpSink() { close(); }
+
+  void addFrame(double t, const std::string &type, const cv::Mat &frame) {
+    if (frame.empty() || closed_)
+      return;
+    queue_.push(Frame {t, type, frame});  // shallow copy, pixel data is refcounted
+  }
+
+  /// Drains the queue, writes the index and finalizes the file.
+  void close() {
+    if (closed_)
+      return;
+    closed_ = true;
+    queue_.close();
+    worker_.join();
+
+    auto index_offset = static_cast<uint64_t>(out_.tellp());
+    writeRaw<uint64_t>(static_cast<uint64_t>(offsets_.size()));
+    out_.write(reinterpret_cast<const char *>(offsets_.data()),
+               static_cast<std::streamsize>(offsets_.size() * sizeof(uint64_t)));
+    writeRaw<uint64_t>(index_offset);
+    out_.write(kFrameIndexMagic, sizeof kFrameIndexMagic);
+    out_.close();
+  }
+
+  uint64_t numFrames() const { return offsets_.size(); }
+
+ private:
+  static constexpr size_t kQueueCapacity = 256;
+
+  struct Frame {
+    double t = 0.0;
+    std::string type;
+    cv::Mat mat;
+  };
+
+  template <typename T>
+  void writeRaw(const T &value) {
+    out_.write(reinterpret_cast<const char *>(&value), sizeof value);
+  }
+
+  void workerLoop() {
+    Frame frame;
+    while (queue_.pop(frame))
+      writeFrame(frame);
+  }
+
+  void writeFrame(const Frame &frame) {
+    cv::Mat mat = frame.mat.isContinuous() ? frame.mat : frame.mat.clone();
+    auto raw_size = static_cast<uint64_t>(mat.total() * mat.elemSize());
+
+    const uint8_t *stored = mat.data;
+    uint64_t stored_size = raw_size;
+#ifdef X_EVALUATE_HAVE_ZSTD
+    scratch_.resize(ZSTD_compressBound(raw_size));
+    stored_size = ZSTD_compress(scratch_.data(), scratch_.size(), mat.data, raw_size, kCompressionLevel);
+    if (ZSTD_isError(stored_size))
+      throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(stored_size));
+    stored = scratch_.data();
+#endif
+
+    offsets_.push_back(static_cast<uint64_t>(out_.tellp()));
+    writeRaw<uint32_t>(static_cast<uint32_t>(frame.type.size()));
+    out_.write(frame.type.data(), static_cast<std::streamsize>(frame.type.size()));
+    writeRaw<double>(frame.t);
+    writeRaw<uint32_t>(static_cast<uint32_t>(mat.rows));
+    writeRaw<uint32_t>(static_cast<uint32_t>(mat.cols));
+    writeRaw<int32_t>(mat.type());
+    writeRaw<uint64_t>(raw_size);
+    writeRaw<uint64_t>(stored_size);
+    out_.write(reinterpret_cast<const char *>(stored), static_cast<std::streamsize>(stored_size));
+  }
+
+#ifdef X_EVALUATE_HAVE_ZSTD
+  static constexpr int kCompressionLevel = 3;  // zstd default: ~4x on our 8-bit frames at negligible CPU cost
+  std::vector<uint8_t> scratch_;
+#endif
+
+  std::ofstream out_;
+  std::vector<uint64_t> offsets_;
+  BoundedQueue<Frame> queue_;
+  std::thread worker_;
+  bool closed_ = false;
+};
+
+}  // namespace x_evaluate
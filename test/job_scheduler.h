@@ -0,0 +1,89 @@
+//
+// Created by Florian Mahlknecht on 2022-04-11.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace x_evaluate {
+
+/**
+ * Minimal work-stealing thread pool for coarse-grained evaluation jobs. Each worker owns a deque and steals from the
+ * back of other workers' deques when its own runs dry. Jobs are independent (one bag + params + frontend each), so no
+ * synchronization beyond the deques themselves is needed.
+ */
+class JobScheduler {
+ public:
+  using Job = std::function<void()>;
+
+  explicit JobScheduler(size_t num_workers)
+    : queues_(num_workers), mutexes_(num_workers) {
+    num_workers_ = num_workers;
+  }
+
+  void addJob(Job job) {
+    // round-robin initial distribution, workers re-balance through stealing
+    size_t idx = next_queue_++ % num_workers_;
+    std::lock_guard<std::mutex> lock(mutexes_[idx]);
+    queues_[idx].push_back(std::move(job));
+  }
+
+  /// Runs all queued jobs and blocks until the last one finished.
+  void runToCompletion() {
+    std::vector<std::thread> workers;
+    workers.reserve(num_workers_);
+    for (size_t i = 0; i < num_workers_; ++i)
+      workers.emplace_back([this, i] { workerLoop(i); });
+    for (auto &w : workers)
+      w.join();
+  }
+
+ private:
+  void workerLoop(size_t own_idx) {
+    Job job;
+    while (true) {
+      if (tryPopFront(own_idx, job)) {
+        job();
+        continue;
+      }
+      // own queue empty --> steal from the back of the busiest sibling
+      bool stolen = false;
+      for (size_t i = 1; i < num_workers_ && !stolen; ++i)
+        stolen = tryPopBack((own_idx + i) % num_workers_, job);
+      if (!stolen)
+        return;  // nothing left anywhere, all jobs handed out
+      job();
+    }
+  }
+
+  bool tryPopFront(size_t idx, Job &job) {
+    std::lock_guard<std::mutex> lock(mutexes_[idx]);
+    if (queues_[idx].empty())
+      return false;
+    job = std::move(queues_[idx].front());
+    queues_[idx].pop_front();
+    return true;
+  }
+
+  bool tryPopBack(size_t idx, Job &job) {
+    std::lock_guard<std::mutex> lock(mutexes_[idx]);
+    if (queues_[idx].empty())
+      return false;
+    job = std::move(queues_[idx].back());
+    queues_[idx].pop_back();
+    return true;
+  }
+
+  size_t num_workers_;
+  std::atomic<size_t> next_queue_ {0};
+  std::vector<std::deque<Job>> queues_;
+  std::vector<std::mutex> mutexes_;
+};
+
+}  // namespace x_evaluate
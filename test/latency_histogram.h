@@ -0,0 +1,76 @@
+//
+// Created by Florian Mahlknecht on 2022-06-13.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Fixed-memory HDR-style latency histogram. Values are bucketed with ~3% relative precision (32 linear sub-buckets
+// per power of two), so percentiles of millions of per-message processing times can be maintained online in ~16 KB
+// instead of re-deriving them from realtime.csv rows in pandas after the run.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace x_evaluate {
+
+class LatencyHistogram {
+ public:
+  void record(uint64_t value_us) {
+    ++counts_[indexOf(value_us)];
+    ++count_;
+    sum_ += value_us;
+    if (value_us < min_) min_ = value_us;
+    if (value_us > max_) max_ = value_us;
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t min() const { return count_ > 0 ? min_ : 0; }
+  uint64_t max() const { return max_; }
+  double mean() const { return count_ > 0 ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+
+  /// Value at quantile q in [0, 1], accurate to the bucket resolution (upper bucket edge, as in HDR histograms).
+  uint64_t quantile(double q) const {
+    if (count_ == 0)
+      return 0;
+    auto target = static_cast<uint64_t>(q * static_cast<double>(count_));
+    if (target >= count_)
+      target = count_ - 1;
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      cumulative += counts_[i];
+      if (cumulative > target)
+        return upperEdgeOf(i);
+    }
+    return max_;
+  }
+
+ private:
+  static constexpr unsigned kSubBucketBits = 5;  // 32 sub-buckets per power of two --> <= 1/32 relative error
+  static constexpr uint64_t kSubBuckets = 1ull << kSubBucketBits;
+  static constexpr size_t kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  static size_t indexOf(uint64_t v) {
+    if (v < kSubBuckets)
+      return static_cast<size_t>(v);
+    unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(v));
+    unsigned bucket = msb - kSubBucketBits + 1;
+    auto sub = static_cast<size_t>((v >> (msb - kSubBucketBits)) - kSubBuckets);
+    return bucket * kSubBuckets + sub;
+  }
+
+  static uint64_t upperEdgeOf(size_t index) {
+    auto bucket = static_cast<unsigned>(index >> kSubBucketBits);
+    uint64_t sub = index & (kSubBuckets - 1);
+    if (bucket == 0)
+      return sub;
+    return ((kSubBuckets + sub + 1) << (bucket - 1)) - 1;
+  }
+
+  std::array<uint64_t, kNumBuckets> counts_ {};
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t min_ = UINT64_MAX;
+  uint64_t max_ = 0;
+};
+
+}  // namespace x_evaluate
@@ -0,0 +1,76 @@
+//
+// Created by Florian Mahlknecht on 2022-07-04.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Message --> x type conversion helpers, moved out of evaluate.cpp so the microbenchmark target can exercise the
+// exact same code paths as the harness. (Originally handy functions from ros_utils.cpp (x_vio_ros) -- ugly
+// duplication but avoids dependency on x_vio_ros.)
+
+#pragma once
+
+#include <vector>
+
+#include <cv_bridge/cv_bridge.h>
+#include <ros/console.h>
+#include <sensor_msgs/image_encodings.h>
+
+#include <dvs_msgs/EventArray.h>
+#include <geometry_msgs/Vector3.h>
+#include <sensor_msgs/Image.h>
+
+#include <x/eklt/types.h>
+#include <x/vio/types.h>
+#include <x/vision/tiled_image.h>
+
+namespace x_evaluate {
+
+inline x::EventArray::Ptr msgToEvents(const dvs_msgs::EventArrayConstPtr &events_msg_ptr) {
+  std::vector<x::Event> event_list;
+  event_list.reserve(events_msg_ptr->events.size());
+
+  for (const auto& e : events_msg_ptr->events) {
+    event_list.emplace_back(e.x, e.y, e.ts.toSec(), e.polarity);
+  }
+
+  x::EventArray::Ptr x_events(new x::EventArray(events_msg_ptr->header.seq, events_msg_ptr->height,
+                                                events_msg_ptr->width, event_list));
+  return x_events;
+}
+
+inline cv_bridge::CvImageConstPtr msgToImage(const sensor_msgs::ImageConstPtr &img) {
+  cv_bridge::CvImageConstPtr cv_ptr;
+  try
+  {
+    cv_ptr = cv_bridge::toCvShare(img, sensor_msgs::image_encodings::MONO8);
+  }
+  catch (cv_bridge::Exception& e)
+  {
+    ROS_ERROR("cv_bridge exception: %s", e.what());
+  }
+  return cv_ptr;
+}
+
+/// deep_copy detaches the pixel buffer from the message: toCvShare() aliases msg->data for MONO8 bags, so callers
+/// whose message (or decoded mat) is shared across runs must not hand the VIO a view it could draw into.
+inline bool msgToTiledImage(const x::Params& params, const sensor_msgs::ImageConstPtr &img,
+                            x::TiledImage &tiledImage, bool deep_copy = false) {
+
+  auto cv_ptr = msgToImage(img);
+  if (!cv_ptr)
+    return false;
+
+  const unsigned int frame_number = img->header.seq;
+  auto timestamp = img->header.stamp.toSec();
+
+  // Shallow copies (unless detached above)
+  tiledImage = x::TiledImage(deep_copy ? cv_ptr->image.clone() : cv_ptr->image, timestamp, frame_number,
+                             params.n_tiles_h, params.n_tiles_w, params.max_feat_per_tile);
+
+  return true;
+}
+
+inline x::Vector3 msgVector3ToEigen(geometry_msgs::Vector3 vector) {
+  return { vector.x, vector.y, vector.z };
+}
+
+}  // namespace x_evaluate
@@ -0,0 +1,204 @@
+//
+// Created by Florian Mahlknecht on 2022-07-18.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Binary side-cache for x::Params. Parameter sweeps launch thousands of short runs, and per-run startup
+// (YAML::LoadFile plus a per-key as<T>() conversion for every parameter) is a visible fraction of total sweep time.
+// The first load of a params .yaml records the typed values the x::ParameterLoader actually consumed and writes them
+// next to the file as <params>.pbin, keyed by a hash of the YAML bytes; subsequent loads of the unchanged file
+// deserialize the recorded values directly and never touch the YAML parser. An edited .yaml changes the hash, so a
+// stale cache is simply ignored and rewritten.
+//
+// File layout: magic[8] | u32 version | u64 yaml_hash | entries until EOF,
+//   entry: u32 key_len | key | u32 value_size | value bytes
+// Values are stored as the in-memory parameter types (raw bytes for trivially copyable types, length-prefixed for
+// strings and vectors), so reading back is a couple of memcpys per key.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+namespace x_evaluate {
+
+constexpr char kParamsCacheMagic[8] = {'X', 'E', 'V', 'P', 'A', 'R', '0', '1'};
+
+template <typename T>
+struct is_std_vector : std::false_type {};
+template <typename U, typename A>
+struct is_std_vector<std::vector<U, A>> : std::true_type {};
+
+/// Appends one parameter value to the blob; vectors recurse per element so nested vectors work too.
+template <typename T>
+void appendParamValue(std::string &blob, const T &value) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    auto len = static_cast<uint32_t>(value.size());
+    blob.append(reinterpret_cast<const char *>(&len), sizeof len);
+    blob.append(value);
+  } else if constexpr (is_std_vector<T>::value) {
+    auto count = static_cast<uint32_t>(value.size());
+    blob.append(reinterpret_cast<const char *>(&count), sizeof count);
+    for (const auto &element : value)
+      appendParamValue(blob, element);
+  } else {
+    static_assert(std::is_trivially_copyable_v<T>, "unsupported parameter type for the binary params cache");
+    blob.append(reinterpret_cast<const char *>(&value), sizeof value);
+  }
+}
+
+/// Counterpart of appendParamValue(); returns false (without touching value) on any size mismatch, e.g. when the
+/// parameter type changed between library versions -- the caller then falls back to the YAML path.
+template <typename T>
+bool extractParamValue(const char *&p, const char *end, T &value) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    uint32_t len = 0;
+    if (end - p < static_cast<ptrdiff_t>(sizeof len))
+      return false;
+    std::memcpy(&len, p, sizeof len);
+    p += sizeof len;
+    if (end - p < static_cast<ptrdiff_t>(len))
+      return false;
+    value.assign(p, len);
+    p += len;
+    return true;
+  } else if constexpr (is_std_vector<T>::value) {
+    uint32_t count = 0;
+    if (end - p < static_cast<ptrdiff_t>(sizeof count))
+      return false;
+    std::memcpy(&count, p, sizeof count);
+    p += sizeof count;
+    value.resize(count);
+    for (auto &element : value)
+      if (!extractParamValue(p, end, element))
+        return false;
+    return true;
+  } else {
+    if (end - p < static_cast<ptrdiff_t>(sizeof value))
+      return false;
+    std::memcpy(&value, p, sizeof value);
+    p += sizeof value;
+    return true;
+  }
+}
+
+class ParamsCache {
+ public:
+  explicit ParamsCache(const std::string &params_file)
+    : cache_file_(params_file + ".pbin") {
+    std::ifstream yaml(params_file, std::ios::binary);
+    if (!yaml)
+      return;
+    std::string content((std::istreambuf_iterator<char>(yaml)), std::istreambuf_iterator<char>());
+    yaml_hash_ = fnv1a(content);
+    tryLoad();
+  }
+
+  /// True when a cache written for exactly these YAML bytes exists -- lookup() then serves the recorded values.
+  bool valid() const { return valid_; }
+  const std::string &cacheFile() const { return cache_file_; }
+
+  template <typename T>
+  bool lookup(const std::string &key, T &par) const {
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+      return false;
+    const char *p = it->second.data();
+    const char *end = p + it->second.size();
+    // the blob must be consumed exactly: a leftover tail means the stored type is wider than what the loader asks
+    // for today (e.g. cached double, now int32) and would otherwise "succeed" with garbage bytes as the value
+    return extractParamValue(p, end, par) && p == end;
+  }
+
+  template <typename T>
+  void record(const std::string &key, const T &par) {
+    std::string blob;
+    appendParamValue(blob, par);
+    entries_[key] = std::move(blob);  // assignment, not append: may overwrite a stale loaded entry
+  }
+
+  /**
+   * Persists the recorded entries. Written to a temp file unique per writer and renamed, so concurrent jobs loading
+   * the same params file (--jobs_file workers on one node or across shared storage) each publish atomically and
+   * never observe a torn cache -- the losing writer just overwrites with identical content.
+   */
+  void write() const {
+    static std::atomic<unsigned> tmp_counter {0};
+    std::string tmp = cache_file_ + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(tmp_counter++);
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      if (!out)
+        return;
+      out.write(kParamsCacheMagic, sizeof kParamsCacheMagic);
+      uint32_t version = 1;
+      out.write(reinterpret_cast<const char *>(&version), sizeof version);
+      out.write(reinterpret_cast<const char *>(&yaml_hash_), sizeof yaml_hash_);
+      for (const auto &[key, blob] : entries_) {
+        auto key_len = static_cast<uint32_t>(key.size());
+        auto value_size = static_cast<uint32_t>(blob.size());
+        out.write(reinterpret_cast<const char *>(&key_len), sizeof key_len);
+        out.write(key.data(), key_len);
+        out.write(reinterpret_cast<const char *>(&value_size), sizeof value_size);
+        out.write(blob.data(), value_size);
+      }
+    }
+    std::rename(tmp.c_str(), cache_file_.c_str());
+  }
+
+ private:
+  static uint64_t fnv1a(const std::string &data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  void tryLoad() {
+    std::ifstream in(cache_file_, std::ios::binary);
+    if (!in)
+      return;
+    char magic[sizeof kParamsCacheMagic];
+    uint32_t version = 0;
+    uint64_t hash = 0;
+    in.read(magic, sizeof magic);
+    in.read(reinterpret_cast<char *>(&version), sizeof version);
+    in.read(reinterpret_cast<char *>(&hash), sizeof hash);
+    if (!in || std::memcmp(magic, kParamsCacheMagic, sizeof magic) != 0 || version != 1 || hash != yaml_hash_)
+      return;  // stale or foreign file --> the YAML path will rewrite it
+
+    std::map<std::string, std::string> entries;
+    while (true) {
+      uint32_t key_len = 0;
+      if (!in.read(reinterpret_cast<char *>(&key_len), sizeof key_len))
+        break;  // clean EOF
+      std::string key(key_len, '\0');
+      uint32_t value_size = 0;
+      if (!in.read(key.data(), key_len) || !in.read(reinterpret_cast<char *>(&value_size), sizeof value_size))
+        return;  // truncated --> ignore the cache entirely
+      std::string blob(value_size, '\0');
+      if (!in.read(blob.data(), value_size))
+        return;
+      entries.emplace(std::move(key), std::move(blob));
+    }
+    entries_ = std::move(entries);
+    valid_ = true;
+  }
+
+  std::string cache_file_;
+  uint64_t yaml_hash_ = 0;
+  bool valid_ = false;
+  std::map<std::string, std::string> entries_;
+};
+
+}  // namespace x_evaluate
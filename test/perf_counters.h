@@ -0,0 +1,111 @@
+//
+// Created by Florian Mahlknecht on 2022-07-11.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Hardware performance counters (perf_event_open) for the per-modality processing blocks. Wall time alone cannot
+// show that a slowdown is cache-miss bound; snapshotting these counters around each VIO call attributes
+// instructions, cycles, cache misses and branch misses per message type -- the attribution external `perf` wrappers
+// around the whole process cannot give. Counters are opened with inherit set, so frontend worker threads spawned
+// later (EKLT/HASTE) are included.
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace x_evaluate {
+
+class PerfCounters {
+ public:
+  struct Sample {
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branch_misses = 0;
+
+    Sample operator-(const Sample &other) const {
+      return {instructions - other.instructions, cycles - other.cycles,
+              cache_misses - other.cache_misses, branch_misses - other.branch_misses};
+    }
+
+    Sample &operator+=(const Sample &other) {
+      instructions += other.instructions;
+      cycles += other.cycles;
+      cache_misses += other.cache_misses;
+      branch_misses += other.branch_misses;
+      return *this;
+    }
+  };
+
+  /// Open before the frontend spawns its worker threads -- inheritance only covers children created afterwards.
+  PerfCounters() {
+    fd_instructions_ = openCounter(PERF_COUNT_HW_INSTRUCTIONS);
+    fd_cycles_ = openCounter(PERF_COUNT_HW_CPU_CYCLES);
+    fd_cache_misses_ = openCounter(PERF_COUNT_HW_CACHE_MISSES);
+    fd_branch_misses_ = openCounter(PERF_COUNT_HW_BRANCH_MISSES);
+    if (!available())
+      std::cerr << "WARNING: perf_event_open failed (check kernel.perf_event_paranoid), "
+                   "--perf_counters output will be empty" << std::endl;
+  }
+
+  ~PerfCounters() {
+    closeCounter(fd_instructions_);
+    closeCounter(fd_cycles_);
+    closeCounter(fd_cache_misses_);
+    closeCounter(fd_branch_misses_);
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool available() const {
+    return fd_instructions_ >= 0 && fd_cycles_ >= 0 && fd_cache_misses_ >= 0 && fd_branch_misses_ >= 0;
+  }
+
+  /// Current running totals; per-block attribution is the difference of two snapshots.
+  Sample read() const {
+    Sample s;
+    s.instructions = readCounter(fd_instructions_);
+    s.cycles = readCounter(fd_cycles_);
+    s.cache_misses = readCounter(fd_cache_misses_);
+    s.branch_misses = readCounter(fd_branch_misses_);
+    return s;
+  }
+
+ private:
+  static int openCounter(uint64_t config) {
+    struct perf_event_attr attr {};
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.inherit = 1;   // include worker threads spawned after the counter is opened
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // NOTE: inherit is incompatible with PERF_FORMAT_GROUP reads --> one fd per counter, read individually
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  static uint64_t readCounter(int fd) {
+    uint64_t value = 0;
+    if (fd >= 0 && ::read(fd, &value, sizeof value) != sizeof value)
+      value = 0;
+    return value;
+  }
+
+  static void closeCounter(int fd) {
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  int fd_instructions_ = -1;
+  int fd_cycles_ = -1;
+  int fd_cache_misses_ = -1;
+  int fd_branch_misses_ = -1;
+};
+
+}  // namespace x_evaluate
@@ -0,0 +1,75 @@
+//
+// Created by Florian Mahlknecht on 2022-04-25.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace x_evaluate {
+
+/**
+ * Bounded single-producer single-consumer queue handing pre-decoded messages from the bag reader thread to the
+ * processing thread. push() blocks once the look-ahead window is full, so prefetch stays a bounded amount of
+ * messages (and therefore memory) ahead of the VIO.
+ */
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  /// Returns false once the queue was cancelled, so producers know to stop early.
+  bool push(T &&item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return queue_.size() < capacity_ || cancelled_; });
+    if (cancelled_)
+      return false;
+    queue_.push_back(std::move(item));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /// Blocks until an item is available, returns false once the queue is closed and drained.
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return !queue_.empty() || closed_ || cancelled_; });
+    if (queue_.empty() || cancelled_)
+      return false;
+    item = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+  }
+
+  /// Unblocks producer and consumer immediately, dropping queued items (used by the early-abort guard).
+  void cancel() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cancelled_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+ private:
+  size_t capacity_;
+  bool closed_ = false;
+  bool cancelled_ = false;
+  std::deque<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_, not_full_;
+};
+
+}  // namespace x_evaluate
@@ -0,0 +1,175 @@
+//
+// Created by Florian Mahlknecht on 2022-06-07.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Dedicated resource sampling thread. Replaces the inline getrusage() block that used to run in the processing loop:
+// sampling now happens on a steady wall-clock interval (so short CPU spikes are not missed when compute time
+// accumulates slowly) and the hot loop is no longer perturbed. Besides the established process-level resource.csv
+// schema, a per-thread companion file breaks CPU usage down by thread -- essential for EKLT/HASTE, whose internal
+// worker threads are invisible in the process-level numbers.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <easy/profiler.h>
+
+#include "row_sink.h"
+
+namespace x_evaluate {
+
+class ResourceSampler {
+ public:
+  using ProcessSink = RowSink<profiler::timestamp_t, double, double, double, size_t, size_t>;
+  using ThreadSink = RowSink<profiler::timestamp_t, uint64_t, std::string, double, double>;
+  using DebugMemoryUsage = std::function<size_t()>;
+
+  ResourceSampler(ProcessSink &process_sink, ThreadSink &thread_sink, DebugMemoryUsage debug_memory_usage,
+                  double interval_s)
+    : process_sink_(process_sink), thread_sink_(thread_sink), debug_memory_usage_(std::move(debug_memory_usage)),
+      interval_s_(interval_s), ticks_per_second_(static_cast<double>(sysconf(_SC_CLK_TCK))) {}
+
+  ~ResourceSampler() { stop(); }
+
+  void start() {
+    gettimeofday(&prev_walltime_, nullptr);
+    getrusage(RUSAGE_SELF, &prev_rusage_);
+    sampler_ = std::thread([this] { samplerLoop(); });
+  }
+
+  /// Idempotent, and safe when start() was never reached (e.g. the run threw while opening its input).
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    wake_up_.notify_one();
+    if (sampler_.joinable())
+      sampler_.join();
+  }
+
+  /// Process-lifetime peak resident set size -- same ru_maxrss source as the periodic resource.csv rows.
+  static size_t peakRssBytes() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024L;
+  }
+
+ private:
+  void samplerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!done_) {
+      wake_up_.wait_for(lock, std::chrono::duration<double>(interval_s_), [this] { return done_; });
+      if (done_)
+        break;
+      sample();
+    }
+  }
+
+  void sample() {
+    struct timeval walltime_new;
+    gettimeofday(&walltime_new, nullptr);
+
+    double walltime_sec_passed = (walltime_new.tv_sec + walltime_new.tv_usec * 1e-6) -
+                                 (prev_walltime_.tv_sec + prev_walltime_.tv_usec * 1e-6);
+
+    struct rusage cur_rusage;
+    getrusage(RUSAGE_SELF, &cur_rusage);
+
+    double cpu_time_usr = (cur_rusage.ru_utime.tv_sec + cur_rusage.ru_utime.tv_usec * 1e-6) -
+                          (prev_rusage_.ru_utime.tv_sec + prev_rusage_.ru_utime.tv_usec * 1e-6);
+    double cpu_time_sys = (cur_rusage.ru_stime.tv_sec + cur_rusage.ru_stime.tv_usec * 1e-6) -
+                          (prev_rusage_.ru_stime.tv_sec + prev_rusage_.ru_stime.tv_usec * 1e-6);
+
+    double cpu_usage = 100 * (cpu_time_sys + cpu_time_usr) / walltime_sec_passed;
+    double cpu_usage_usr = 100 * cpu_time_usr / walltime_sec_passed;
+    double cpu_usage_sys = 100 * cpu_time_sys / walltime_sec_passed;
+
+    size_t mem_usage_in_bytes = cur_rusage.ru_maxrss * 1024L;
+    size_t mem_usage_debug = debug_memory_usage_();  // only reads counters, safe off the processing thread
+
+    auto ts = profiler::now();
+    process_sink_.addRow(ts, cpu_usage, cpu_usage_usr, cpu_usage_sys, mem_usage_in_bytes, mem_usage_debug);
+
+    sampleThreads(ts, walltime_sec_passed);
+
+    prev_walltime_ = walltime_new;
+    prev_rusage_ = cur_rusage;
+  }
+
+  void sampleThreads(profiler::timestamp_t ts, double walltime_sec_passed) {
+    DIR *task_dir = opendir("/proc/self/task");
+    if (task_dir == nullptr)
+      return;
+
+    while (struct dirent *entry = readdir(task_dir)) {
+      if (entry->d_name[0] == '.')
+        continue;
+      uint64_t tid = std::strtoull(entry->d_name, nullptr, 10);
+
+      std::ifstream stat_file("/proc/self/task/" + std::string(entry->d_name) + "/stat");
+      std::string line;
+      if (!std::getline(stat_file, line))
+        continue;
+
+      // field 2 (comm) is parenthesized and may contain spaces --> split around the last ')'
+      auto comm_begin = line.find('(');
+      auto comm_end = line.rfind(')');
+      if (comm_begin == std::string::npos || comm_end == std::string::npos)
+        continue;
+      std::string thread_name = line.substr(comm_begin + 1, comm_end - comm_begin - 1);
+
+      std::istringstream rest(line.substr(comm_end + 2));
+      std::string field;
+      uint64_t utime_ticks = 0, stime_ticks = 0;
+      // fields 3..15, utime/stime are 14 and 15 --> indices 11 and 12 after comm
+      for (int i = 0; i < 13 && (rest >> field); ++i) {
+        if (i == 11)
+          utime_ticks = std::strtoull(field.c_str(), nullptr, 10);
+        else if (i == 12)
+          stime_ticks = std::strtoull(field.c_str(), nullptr, 10);
+      }
+
+      auto &prev = prev_thread_ticks_[tid];
+      double cpu_usage_usr = 100 * (utime_ticks - prev.first) / ticks_per_second_ / walltime_sec_passed;
+      double cpu_usage_sys = 100 * (stime_ticks - prev.second) / ticks_per_second_ / walltime_sec_passed;
+      bool first_sighting = prev.first == 0 && prev.second == 0;
+      prev = {utime_ticks, stime_ticks};
+
+      if (!first_sighting)
+        thread_sink_.addRow(ts, tid, thread_name, cpu_usage_usr, cpu_usage_sys);
+    }
+    closedir(task_dir);
+  }
+
+  ProcessSink &process_sink_;
+  ThreadSink &thread_sink_;
+  DebugMemoryUsage debug_memory_usage_;
+  double interval_s_;
+  double ticks_per_second_;
+
+  struct timeval prev_walltime_ {};
+  struct rusage prev_rusage_ {};
+  std::map<uint64_t, std::pair<uint64_t, uint64_t>> prev_thread_ticks_;
+
+  bool done_ = false;
+  std::thread sampler_;
+  std::mutex mutex_;
+  std::condition_variable wake_up_;
+};
+
+}  // namespace x_evaluate
@@ -0,0 +1,318 @@
+//
+// Created by Florian Mahlknecht on 2022-05-02.
+// Copyright (c) 2022 NASA / JPL. All rights reserved.
+//
+// Output row sinks for the evaluation harness. The default sink keeps writing the established CSV files through
+// x::CsvWriter; the binary columnar sink writes the same column schema as packed chunks, avoiding the per-row text
+// formatting that dominates logging cost at kHz IMU rates. scripts/convert_binary_output.py turns .bin files back
+// into the CSVs the Python pipeline expects.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <x/common/csv_writer.h>
+
+namespace x_evaluate {
+
+enum class ColumnType : uint8_t {
+  F64 = 0,  // doubles and floats
+  U64 = 1,  // all integral types
+  STR = 2,
+};
+
+template <typename T>
+constexpr ColumnType columnTypeOf() {
+  if constexpr (std::is_same_v<T, std::string>)
+    return ColumnType::STR;
+  else if constexpr (std::is_floating_point_v<T>)
+    return ColumnType::F64;
+  else
+    return ColumnType::U64;
+}
+
+/// Common interface so the harness can log rows without caring whether they end up as CSV text or binary chunks.
+template <typename... Ts>
+class RowSink {
+ public:
+  using Row = std::tuple<Ts...>;
+
+  virtual ~RowSink() = default;
+  virtual void addRow(const Ts &... values) = 0;
+
+  /// Block write of pre-converted rows (e.g. one tf2 ground-truth batch). The synchronous sinks just loop; the
+  /// async sink overrides this to hand the whole block over under a single critical section.
+  virtual void addRows(const std::vector<Row> &rows) {
+    for (const auto &row : rows)
+      std::apply([this](const Ts &... values) { addRow(values...); }, row);
+  }
+
+  virtual void flush() {}
+};
+
+template <typename... Ts>
+class CsvRowSink : public RowSink<Ts...> {
+ public:
+  CsvRowSink(const std::string &filename, std::initializer_list<std::string> headers)
+    : csv_(filename, headers) {}
+
+  void addRow(const Ts &... values) override { csv_.addRow(values...); }
+
+ private:
+  x::CsvWriter<Ts...> csv_;
+};
+
+/**
+ * CSV sink that appends to an existing file without re-writing the header -- used on checkpoint resume
+ * (x::CsvWriter always truncates). Writes the same ';'-separated format.
+ */
+template <typename... Ts>
+class AppendingCsvRowSink : public RowSink<Ts...> {
+ public:
+  explicit AppendingCsvRowSink(const std::string &filename)
+    : out_(filename, std::ios::app) {
+    if (!out_)
+      throw std::runtime_error("unable to open '" + filename + "' for appending");
+    out_ << std::setprecision(16);
+  }
+
+  void addRow(const Ts &... values) override {
+    writeRow(std::index_sequence_for<Ts...>{}, values...);
+  }
+
+  void flush() override { out_.flush(); }
+
+ private:
+  template <size_t... Is>
+  void writeRow(std::index_sequence<Is...>, const Ts &... values) {
+    ((out_ << (Is == 0 ? "" : ";") << values), ...);
+    out_ << "\n";
+  }
+
+  std::ofstream out_;
+};
+
+/// Swallows rows: --metrics_only runs keep every addRow call site untouched while writing no row files at all.
+template <typename... Ts>
+class NullRowSink : public RowSink<Ts...> {
+ public:
+  void addRow(const Ts &...) override {}
+  void addRows(const std::vector<std::tuple<Ts...>> &) override {}
+};
+
+constexpr char kBinaryColumnarMagic[8] = {'X', 'E', 'V', 'B', 'I', 'N', '0', '1'};
+
+/**
+ * Columnar binary writer: rows are buffered per column and written in chunks of kChunkRows. Numeric columns are
+ * packed 8-byte values, string columns are u32-length-prefixed bytes. File layout:
+ *   magic[8] | u32 num_columns | per column (u8 type, u16 name_len, name) | chunks until EOF
+ *   chunk: u64 num_rows | per column (u64 byte_size, bytes)
+ */
+template <typename... Ts>
+class BinaryColumnarSink : public RowSink<Ts...> {
+ public:
+  static constexpr size_t kChunkRows = 4096;
+
+  BinaryColumnarSink(const std::string &filename, std::initializer_list<std::string> headers, bool append = false)
+    : out_(filename, std::ios::binary | (append ? std::ios::app : std::ios::trunc)) {
+    if (!out_)
+      throw std::runtime_error("unable to open binary output file '" + filename + "'");
+    if (append)
+      return;  // file header already present, chunks are self-delimiting
+    out_.write(kBinaryColumnarMagic, sizeof kBinaryColumnarMagic);
+    writeRaw<uint32_t>(sizeof...(Ts));
+    const ColumnType types[] = {columnTypeOf<Ts>()...};
+    size_t i = 0;
+    for (const auto &name : headers) {
+      writeRaw<uint8_t>(static_cast<uint8_t>(types[i++]));
+      writeRaw<uint16_t>(static_cast<uint16_t>(name.size()));
+      out_.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+  }
+
+  ~BinaryColumnarSink() override { flushChunk(); }
+
+  void addRow(const Ts &... values) override {
+    addRowImpl(std::index_sequence_for<Ts...>{}, values...);
+    if (++num_buffered_ >= kChunkRows)
+      flushChunk();
+  }
+
+  void flush() override {
+    flushChunk();
+    out_.flush();
+  }
+
+ private:
+  template <typename T>
+  void writeRaw(const T &value) {
+    out_.write(reinterpret_cast<const char *>(&value), sizeof value);
+  }
+
+  template <typename T>
+  void bufferValue(std::vector<uint8_t> &column, const T &value) {
+    if constexpr (std::is_same_v<T, std::string>) {
+      auto len = static_cast<uint32_t>(value.size());
+      const auto *p = reinterpret_cast<const uint8_t *>(&len);
+      column.insert(column.end(), p, p + sizeof len);
+      column.insert(column.end(), value.begin(), value.end());
+    } else if constexpr (std::is_floating_point_v<T>) {
+      auto v = static_cast<double>(value);
+      const auto *p = reinterpret_cast<const uint8_t *>(&v);
+      column.insert(column.end(), p, p + sizeof v);
+    } else {
+      auto v = static_cast<uint64_t>(value);
+      const auto *p = reinterpret_cast<const uint8_t *>(&v);
+      column.insert(column.end(), p, p + sizeof v);
+    }
+  }
+
+  template <size_t... Is>
+  void addRowImpl(std::index_sequence<Is...>, const Ts &... values) {
+    (bufferValue(columns_[Is], values), ...);
+  }
+
+  void flushChunk() {
+    if (num_buffered_ == 0)
+      return;
+    writeRaw<uint64_t>(num_buffered_);
+    for (auto &column : columns_) {
+      writeRaw<uint64_t>(column.size());
+      out_.write(reinterpret_cast<const char *>(column.data()), static_cast<std::streamsize>(column.size()));
+      column.clear();
+    }
+    num_buffered_ = 0;
+  }
+
+  std::ofstream out_;
+  std::vector<uint8_t> columns_[sizeof...(Ts)];
+  uint64_t num_buffered_ = 0;
+};
+
+/**
+ * Decouples the logging calls in the hot loop from disk I/O: addRow() copies the row into a preallocated ring buffer
+ * and returns, a dedicated flusher thread drains the buffer in large batches into the wrapped sink. If the ring
+ * buffer ever fills up, addRow() blocks rather than dropping rows. flush() drains synchronously, preserving the
+ * flush-on-exit crash safety of the synchronous sinks.
+ */
+template <typename... Ts>
+class AsyncRowSink : public RowSink<Ts...> {
+ public:
+  static constexpr size_t kCapacity = 1 << 14;
+
+  explicit AsyncRowSink(std::unique_ptr<RowSink<Ts...>> inner)
+    : inner_(std::move(inner)), buffer_(kCapacity) {
+    flusher_ = std::thread([this] { flusherLoop(); });
+  }
+
+  ~AsyncRowSink() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    not_empty_.notify_one();
+    flusher_.join();
+  }
+
+  void addRow(const Ts &... values) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return size_ < kCapacity; });
+    buffer_[(head_ + size_) % kCapacity] = std::tuple<Ts...>(values...);
+    ++size_;
+    lock.unlock();
+    not_empty_.notify_one();
+  }
+
+  void addRows(const std::vector<std::tuple<Ts...>> &rows) override {
+    size_t i = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (i < rows.size()) {
+      not_full_.wait(lock, [this] { return size_ < kCapacity; });
+      while (i < rows.size() && size_ < kCapacity) {
+        buffer_[(head_ + size_) % kCapacity] = rows[i++];
+        ++size_;
+      }
+      not_empty_.notify_one();
+    }
+  }
+
+  void flush() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return size_ == 0 && !writing_; });
+    inner_->flush();
+  }
+
+ private:
+  void flusherLoop() {
+    std::vector<std::tuple<Ts...>> batch;
+    batch.reserve(1024);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      not_empty_.wait(lock, [this] { return size_ > 0 || done_; });
+      if (size_ == 0 && done_)
+        break;
+
+      while (size_ > 0) {
+        batch.push_back(std::move(buffer_[head_]));
+        head_ = (head_ + 1) % kCapacity;
+        --size_;
+      }
+      writing_ = true;
+      lock.unlock();
+      not_full_.notify_all();
+
+      for (const auto &row : batch)
+        std::apply([this](const Ts &... values) { inner_->addRow(values...); }, row);
+      batch.clear();
+
+      lock.lock();
+      writing_ = false;
+      drained_.notify_all();
+    }
+    lock.unlock();
+    drained_.notify_all();
+  }
+
+  std::unique_ptr<RowSink<Ts...>> inner_;
+  std::vector<std::tuple<Ts...>> buffer_;
+  size_t head_ = 0, size_ = 0;
+  bool done_ = false, writing_ = false;
+  std::thread flusher_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_, not_full_, drained_;
+};
+
+/// Creates the sink for one output file; with binary=true the .csv extension is swapped for .bin, with null=true
+/// no file is written at all (--metrics_only).
+template <typename... Ts>
+std::unique_ptr<RowSink<Ts...>> makeRowSink(bool binary, bool async, std::string csv_filename,
+                                            std::initializer_list<std::string> headers, bool append = false,
+                                            bool null = false) {
+  if (null)
+    return std::make_unique<NullRowSink<Ts...>>();
+  std::unique_ptr<RowSink<Ts...>> sink;
+  if (binary) {
+    auto dot = csv_filename.rfind('.');
+    csv_filename = csv_filename.substr(0, dot) + ".bin";
+    sink = std::make_unique<BinaryColumnarSink<Ts...>>(csv_filename, headers, append);
+  } else if (append) {
+    sink = std::make_unique<AppendingCsvRowSink<Ts...>>(csv_filename);
+  } else {
+    sink = std::make_unique<CsvRowSink<Ts...>>(csv_filename, headers);
+  }
+  if (async)
+    sink = std::make_unique<AsyncRowSink<Ts...>>(std::move(sink));
+  return sink;
+}
+
+}  // namespace x_evaluate